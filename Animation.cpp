@@ -2,11 +2,11 @@
 
 #include <utility>
 
-sg::Animation::Animation(AtlasDescriptor _descriptor, DoubleVector const &_position)
+sg::Animation::Animation(AtlasDescriptor _descriptor, DoubleVector const &_position, AnimationDuration const &_current)
         : descriptor_{std::move(_descriptor)},
           position_{_position},
-          current_{0},
-          animation_{_descriptor.animation.value()} {
+          current_{_current},
+          animation_{descriptor_.animation.value()} {
 }
 
 void sg::Animation::update(const AnimationDuration &d) {
@@ -28,3 +28,11 @@ bool sg::Animation::done() const {
 void sg::Animation::move(DoubleVector const &v) {
   this->position_ += v;
 }
+
+sg::DoubleVector const &sg::Animation::position() const {
+  return this->position_;
+}
+
+sg::AnimationDuration const &sg::Animation::current() const {
+  return this->current_;
+}
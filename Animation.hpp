@@ -8,12 +8,14 @@
 namespace sg {
 class Animation {
 public:
-  Animation(AtlasDescriptor, DoubleVector const &position);
+  Animation(AtlasDescriptor, DoubleVector const &position, AnimationDuration const &current = AnimationDuration{0});
 
   void update(AnimationDuration const &);
   [[nodiscard]] RenderObjectList render() const;
   [[nodiscard]] bool done() const;
   void move(DoubleVector const &);
+  [[nodiscard]] DoubleVector const &position() const;
+  [[nodiscard]] AnimationDuration const &current() const;
 private:
   AtlasDescriptor descriptor_;
   DoubleVector position_;
@@ -0,0 +1,173 @@
+#include "AssetPack.hpp"
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+char const magic[4]{'S', 'G', 'P', 'K'};
+std::uint32_t const version{1};
+
+std::string index_key(std::filesystem::path const &p) {
+  return p.lexically_normal().generic_string();
+}
+
+template<typename T>
+void write_raw(std::ofstream &out, T const &t) {
+  out.write(reinterpret_cast<char const *>(&t), sizeof(T));
+}
+
+class Reader {
+public:
+  Reader(unsigned char const *_data, std::size_t const _size) : data_{_data}, size_{_size}, position_{0} {}
+
+  template<typename T>
+  T read() {
+    T result;
+    std::memcpy(&result, bytes(sizeof(T)), sizeof(T));
+    return result;
+  }
+
+  std::string read_string(std::size_t const length) {
+    return std::string{reinterpret_cast<char const *>(bytes(length)), length};
+  }
+
+private:
+  unsigned char const *data_;
+  std::size_t size_;
+  std::size_t position_;
+
+  unsigned char const *bytes(std::size_t const n) {
+    if (size_ - position_ < n)
+      throw std::runtime_error{"asset pack index is truncated"};
+    auto const result{data_ + position_};
+    position_ += n;
+    return result;
+  }
+};
+}
+
+std::uint32_t sg::fnv1a(unsigned char const *data, std::size_t const size) {
+  std::uint32_t hash{2166136261u};
+  for (std::size_t i{0}; i < size; ++i) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+sg::AssetPack::AssetPack() : data_{nullptr}, mapped_size_{0}, index_{} {}
+
+sg::AssetPack::AssetPack(void *_data, std::size_t const _mapped_size, Index _index)
+        : data_{_data}, mapped_size_{_mapped_size}, index_{std::move(_index)} {}
+
+sg::AssetPack::AssetPack(AssetPack &&o) noexcept
+        : data_{o.data_}, mapped_size_{o.mapped_size_}, index_{std::move(o.index_)} {
+  o.data_ = nullptr;
+  o.mapped_size_ = 0;
+}
+
+sg::AssetPack &sg::AssetPack::operator=(AssetPack &&o) noexcept {
+  std::swap(data_, o.data_);
+  std::swap(mapped_size_, o.mapped_size_);
+  index_.swap(o.index_);
+  return *this;
+}
+
+sg::AssetPack::~AssetPack() {
+  if (data_ != nullptr)
+    munmap(data_, mapped_size_);
+}
+
+sg::AssetPack sg::AssetPack::map(std::filesystem::path const &p) {
+  int const fd{::open(p.c_str(), O_RDONLY)};
+  if (fd == -1)
+    throw std::runtime_error{"couldn't open asset pack " + p.string() + ": " + std::strerror(errno)};
+  struct stat st{};
+  if (fstat(fd, &st) == -1) {
+    ::close(fd);
+    throw std::runtime_error{"couldn't stat asset pack " + p.string() + ": " + std::strerror(errno)};
+  }
+  auto const size{static_cast<std::size_t>(st.st_size)};
+  void *const data{mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+  ::close(fd);
+  if (data == MAP_FAILED)
+    throw std::runtime_error{"couldn't map asset pack " + p.string() + ": " + std::strerror(errno)};
+  // Unmaps again should reading the index throw.
+  AssetPack result{data, size, Index{}};
+
+  Reader reader{static_cast<unsigned char const *>(data), size};
+  if (reader.read_string(sizeof(magic)) != std::string{magic, sizeof(magic)})
+    throw std::runtime_error{p.string() + " is not an asset pack"};
+  if (reader.read<std::uint32_t>() != version)
+    throw std::runtime_error{p.string() + " has an unsupported asset pack version"};
+  auto const count{reader.read<std::uint32_t>()};
+  for (std::uint32_t i{0}; i < count; ++i) {
+    auto const name{reader.read_string(reader.read<std::uint32_t>())};
+    Entry e{};
+    e.offset = reader.read<std::uint64_t>();
+    e.size = reader.read<std::uint64_t>();
+    e.checksum = reader.read<std::uint32_t>();
+    if (e.offset > size || e.size > size - e.offset)
+      throw std::runtime_error{"asset \"" + name + "\" lies outside of " + p.string()};
+    result.index_.insert(Index::value_type{name, e});
+  }
+  return result;
+}
+
+void sg::AssetPack::write(std::filesystem::path const &out_path, std::vector<std::filesystem::path> const &files) {
+  std::uint64_t index_size{sizeof(magic) + 2 * sizeof(std::uint32_t)};
+  for (std::filesystem::path const &f : files)
+    index_size += sizeof(std::uint32_t) + index_key(f).size() + 2 * sizeof(std::uint64_t) + sizeof(std::uint32_t);
+
+  std::vector<std::vector<unsigned char>> contents;
+  for (std::filesystem::path const &f : files) {
+    std::ifstream in{f, std::ios::binary};
+    if (!in)
+      throw std::runtime_error{"couldn't read " + f.string()};
+    contents.emplace_back(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+  }
+
+  std::ofstream out{out_path, std::ios::binary | std::ios::trunc};
+  if (!out)
+    throw std::runtime_error{"couldn't write " + out_path.string()};
+  out.write(magic, sizeof(magic));
+  write_raw(out, version);
+  write_raw(out, static_cast<std::uint32_t>(files.size()));
+  std::uint64_t offset{index_size};
+  for (std::size_t i{0}; i < files.size(); ++i) {
+    auto const key{index_key(files[i])};
+    write_raw(out, static_cast<std::uint32_t>(key.size()));
+    out.write(key.data(), static_cast<std::streamsize>(key.size()));
+    write_raw(out, offset);
+    write_raw(out, static_cast<std::uint64_t>(contents[i].size()));
+    write_raw(out, fnv1a(contents[i].data(), contents[i].size()));
+    offset += contents[i].size();
+  }
+  for (std::vector<unsigned char> const &c : contents)
+    out.write(reinterpret_cast<char const *>(c.data()), static_cast<std::streamsize>(c.size()));
+  if (!out)
+    throw std::runtime_error{"couldn't write " + out_path.string()};
+}
+
+std::optional<std::string_view> sg::AssetPack::find(std::filesystem::path const &p) const {
+  auto const it{index_.find(index_key(p))};
+  if (it == index_.end())
+    return std::nullopt;
+  auto const *const bytes{static_cast<unsigned char const *>(data_) + it->second.offset};
+  if (fnv1a(bytes, it->second.size) != it->second.checksum)
+    throw std::runtime_error{"asset \"" + it->first + "\" is corrupt (checksum mismatch)"};
+  return std::string_view{reinterpret_cast<char const *>(bytes), it->second.size};
+}
+
+SDL_RWops *sg::AssetPack::open(std::filesystem::path const &p) const {
+  auto const packed{find(p)};
+  SDL_RWops *const result{packed.has_value()
+                          ? SDL_RWFromConstMem(packed->data(), static_cast<int>(packed->size()))
+                          : SDL_RWFromFile(p.c_str(), "rb")};
+  if (result == nullptr)
+    throw std::runtime_error{"couldn't open asset " + p.string() + ": " + std::string{SDL_GetError()}};
+  return result;
+}
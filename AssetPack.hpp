@@ -0,0 +1,58 @@
+#pragma once
+
+#include <SDL.h>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "util.hpp"
+
+namespace sg {
+std::uint32_t fnv1a(unsigned char const *, std::size_t);
+
+// A single file holding every asset, indexed by the path the asset would
+// have on disk. The file is memory-mapped, so only touched assets are paged
+// in. Assets missing from the pack (or every asset, for a default-constructed
+// pack) are read from the loose file instead.
+class AssetPack {
+public:
+  struct Entry {
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint32_t checksum;
+  };
+
+  using Index = std::map<std::string, Entry>;
+
+  AssetPack();
+
+  static AssetPack map(std::filesystem::path const &);
+
+  static void write(std::filesystem::path const &, std::vector<std::filesystem::path> const &);
+
+  SG_NONCOPYABLE(AssetPack);
+
+  AssetPack(AssetPack &&) noexcept;
+
+  AssetPack &operator=(AssetPack &&) noexcept;
+
+  ~AssetPack();
+
+  [[nodiscard]] std::optional<std::string_view> find(std::filesystem::path const &) const;
+
+  // The caller owns the result (pass freesrc=1 to the SDL loaders).
+  [[nodiscard]] SDL_RWops *open(std::filesystem::path const &) const;
+
+  [[nodiscard]] std::size_t size() const { return index_.size(); }
+
+private:
+  AssetPack(void *, std::size_t, Index);
+
+  void *data_;
+  std::size_t mapped_size_;
+  Index index_;
+};
+}
@@ -0,0 +1,139 @@
+#include "AssetReloader.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+// Editors and exporters write files in several steps; wait for them to
+// settle before reloading.
+std::chrono::milliseconds const settle_time{100};
+int const poll_timeout_ms{50};
+}
+
+sg::AssetReloader::AssetReloader(std::filesystem::path const &_root,
+                                 AssetPack const &_assets,
+                                 SDLImageContext &_image_context,
+                                 SDLRenderer &_renderer,
+                                 SDLMixerContext &_mixer_context)
+        : assets_{_assets},
+          image_context_{_image_context},
+          renderer_{_renderer},
+          mixer_context_{_mixer_context},
+          fd_{inotify_init1(IN_NONBLOCK | IN_CLOEXEC)},
+          watches_{},
+          stop_{false},
+          mutex_{},
+          reloaded_{},
+          thread_{} {
+  if (fd_ < 0)
+    throw std::runtime_error{std::string{"couldn't initialize inotify: "} + std::strerror(errno)};
+  watch(_root);
+  for (std::filesystem::directory_entry const &e : std::filesystem::recursive_directory_iterator{_root})
+    if (e.is_directory())
+      watch(e.path());
+  thread_ = std::thread{[this]() { run(); }};
+}
+
+sg::AssetReloader::~AssetReloader() {
+  stop_ = true;
+  thread_.join();
+  ::close(fd_);
+}
+
+void sg::AssetReloader::watch(std::filesystem::path const &directory) {
+  int const wd{inotify_add_watch(fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO)};
+  if (wd < 0) {
+    auto const error{errno};
+    ::close(fd_);
+    throw std::runtime_error{"couldn't watch " + directory.string() + ": " + std::strerror(error)};
+  }
+  watches_.insert(std::map<int, std::filesystem::path>::value_type{wd, directory});
+}
+
+std::vector<std::string> sg::AssetReloader::apply(TextureCache &textures, AtlasCache &atlases, FontCache &fonts,
+                                                  SoundCache &sounds) {
+  std::vector<Reloaded> ready;
+  {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    ready.swap(reloaded_);
+  }
+  std::vector<std::string> result;
+  for (Reloaded &r : ready) {
+    if (auto *const image{std::get_if<ReloadedImage>(&r)}) {
+      bool const texture{textures.replace(image->path, image->prepared)};
+      bool const tiles{image->tiles.has_value() && atlases.replace_tiles(image->path, image->tiles.value())};
+      if (texture || tiles)
+        result.push_back("reloaded " + image->path.string());
+    } else if (auto *const font{std::get_if<ReloadedFont>(&r)}) {
+      if (fonts.reload(font->path))
+        result.push_back("reloaded " + font->path.string());
+    } else if (auto *const sound{std::get_if<ReloadedSound>(&r)}) {
+      if (sounds.replace(sound->path, std::move(sound->sound)))
+        result.push_back("reloaded " + sound->path.string());
+    } else if (auto *const failed{std::get_if<ReloadFailed>(&r)}) {
+      result.push_back("couldn't reload " + failed->path.string() + ": " + failed->error);
+    }
+  }
+  return result;
+}
+
+void sg::AssetReloader::run() {
+  std::set<std::filesystem::path> pending;
+  Clock::time_point last_change{};
+  alignas(inotify_event) char buffer[4096];
+  while (!stop_) {
+    pollfd p{fd_, POLLIN, 0};
+    if (::poll(&p, 1, poll_timeout_ms) > 0) {
+      for (ssize_t n; (n = ::read(fd_, buffer, sizeof(buffer))) > 0;) {
+        for (char const *it{buffer}; it < buffer + n;) {
+          auto const *const event{reinterpret_cast<inotify_event const *>(it)};
+          auto const watch{watches_.find(event->wd)};
+          if (event->len > 0 && (event->mask & IN_ISDIR) == 0 && watch != watches_.end())
+            pending.insert(watch->second / event->name);
+          it += sizeof(inotify_event) + event->len;
+        }
+        last_change = Clock::now();
+      }
+    }
+    if (pending.empty() || Clock::now() - last_change < settle_time)
+      continue;
+    for (std::filesystem::path const &changed : pending) {
+      std::optional<Reloaded> r;
+      try {
+        r = load(changed);
+      } catch (std::exception const &e) {
+        r = ReloadFailed{changed, e.what()};
+      }
+      if (r.has_value()) {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        reloaded_.push_back(std::move(r.value()));
+      }
+    }
+    pending.clear();
+  }
+}
+
+std::optional<sg::AssetReloader::Reloaded> sg::AssetReloader::load(std::filesystem::path const &p) {
+  auto const extension{p.extension()};
+  if (extension == ".png" || extension == ".json") {
+    // A changed atlas description reloads its image, too
+    auto const image_path{std::filesystem::path{p}.replace_extension(".png")};
+    if (!std::filesystem::exists(image_path))
+      return std::nullopt;
+    SDLSurface loaded{image_context_.load_surface(image_path)};
+    std::optional<Atlas::Tiles> tiles;
+    if (std::filesystem::exists(std::filesystem::path{p}.replace_extension(".json")))
+      tiles = Atlas::load_tiles(assets_, AtlasDescriptor{image_path, std::nullopt}, loaded);
+    return ReloadedImage{image_path, renderer_.prepare_surface(loaded), std::move(tiles)};
+  }
+  if (extension == ".ttf")
+    return ReloadedFont{p};
+  if (extension == ".wav" || extension == ".ogg")
+    return ReloadedSound{p, mixer_context_.load_sound(p)};
+  return std::nullopt;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+#include "Atlas.hpp"
+#include "FontCache.hpp"
+#include "SDL.hpp"
+#include "TextureCache.hpp"
+#include "sound_cache.hpp"
+#include "util.hpp"
+
+namespace sg {
+// Watches a directory tree with inotify and reloads the assets written to
+// it. Changed files are decoded on a background thread; apply() only swaps
+// the results into the caches. Files are always read from disk, so this is
+// of no use while running from an asset pack.
+class AssetReloader {
+public:
+  AssetReloader(std::filesystem::path const &root, AssetPack const &, SDLImageContext &, SDLRenderer &,
+                SDLMixerContext &);
+
+  SG_NONCOPYABLE(AssetReloader);
+  SG_NONMOVEABLE(AssetReloader);
+
+  ~AssetReloader();
+
+  // One line per asset reloaded or failed to reload since the last call
+  std::vector<std::string> apply(TextureCache &, AtlasCache &, FontCache &, SoundCache &);
+
+private:
+  struct ReloadedImage {
+    std::filesystem::path path;
+    SDLSurface prepared;
+    std::optional<Atlas::Tiles> tiles;
+  };
+
+  struct ReloadedFont {
+    std::filesystem::path path;
+  };
+
+  struct ReloadedSound {
+    std::filesystem::path path;
+    MixerSound sound;
+  };
+
+  struct ReloadFailed {
+    std::filesystem::path path;
+    std::string error;
+  };
+
+  using Reloaded = std::variant<ReloadedImage, ReloadedFont, ReloadedSound, ReloadFailed>;
+
+  AssetPack const &assets_;
+  SDLImageContext &image_context_;
+  SDLRenderer &renderer_;
+  SDLMixerContext &mixer_context_;
+  int fd_;
+  std::map<int, std::filesystem::path> watches_;
+  std::atomic<bool> stop_;
+  std::mutex mutex_;
+  std::vector<Reloaded> reloaded_;
+  std::thread thread_;
+
+  void watch(std::filesystem::path const &directory);
+
+  void run();
+
+  std::optional<Reloaded> load(std::filesystem::path const &);
+};
+}
@@ -3,10 +3,10 @@
 #include <fstream>
 #include <utility>
 
-sg::Atlas sg::Atlas::from_descriptor(TextureCache &textures, const AtlasDescriptor &descriptor) {
+sg::Atlas sg::Atlas::from_descriptor(AssetPack const &assets, TextureCache &textures, const AtlasDescriptor &descriptor) {
   if (descriptor.animation.has_value()) {
     auto const animation = descriptor.animation.value();
-    SDLTexture &texture{textures.get_texture(descriptor.path)};
+    SDLTexture &texture{textures.pin(descriptor.path)};
     int const per_row{texture.size().x() / animation.tile_size.x()};
     AtlasMap atlas;
     for (unsigned i{0}; i < animation.tile_count; ++i) {
@@ -15,11 +15,22 @@ sg::Atlas sg::Atlas::from_descriptor(TextureCache &textures, const AtlasDescript
     }
     return Atlas{texture, atlas};
   }
+  SDLSurface loaded{textures.load_surface(descriptor.path)};
+  Tiles tiles{load_tiles(assets, descriptor, loaded)};
+  return Atlas{textures.pin(descriptor.path), std::move(tiles.atlas), std::move(tiles.masks)};
+}
+
+sg::Atlas::Tiles sg::Atlas::load_tiles(AssetPack const &assets, AtlasDescriptor const &descriptor,
+                                       SDLSurface &image) {
   AtlasMap atlas_;
   auto const json_path = std::filesystem::path(descriptor.path).replace_extension(".json");
-  std::ifstream json_file{json_path};
   nlohmann::json atlas_json;
-  json_file >> atlas_json;
+  if (auto const packed{assets.find(json_path)}; packed.has_value()) {
+    atlas_json = nlohmann::json::parse(packed->begin(), packed->end());
+  } else {
+    std::ifstream json_file{json_path};
+    json_file >> atlas_json;
+  }
   auto const frames = atlas_json.find("frames");
   if (frames == atlas_json.end())
     throw std::runtime_error{"couldn't find \"frames\" in " + json_path.string()};
@@ -33,28 +44,47 @@ sg::Atlas sg::Atlas::from_descriptor(TextureCache &textures, const AtlasDescript
                                                                            sg::IntVector{frame->at("w"),
                                                                                          frame->at("h")})});
   }
-  return Atlas{textures.get_texture(descriptor.path), atlas_};
+  SDLSurface const pixels{SDL_ConvertSurfaceFormat(image.surface(), SDL_PIXELFORMAT_RGBA32, 0)};
+  if (pixels.surface() == nullptr)
+    throw std::runtime_error{"couldn't convert " + descriptor.path.string() + ": " + std::string{SDL_GetError()}};
+  MaskMap masks;
+  for (AtlasMap::value_type const &tile : atlas_)
+    masks.insert(MaskMap::value_type{tile.first, CollisionMask::from_alpha(pixels.surface(), tile.second)});
+  return Tiles{std::move(atlas_), std::move(masks)};
+}
+
+void sg::Atlas::replace_tiles(Tiles tiles) {
+  atlas_ = std::move(tiles.atlas);
+  masks_ = std::move(tiles.masks);
 }
 
 void sg::Atlas::render_tile(sg::SDLRenderer &renderer, TexturePath const &tile, const sg::IntRectangle &to) const {
   renderer.copy(*texture_, atlas_.at(tile.path), to);
 }
 
-sg::Atlas::Atlas(sg::Atlas &&o) noexcept: texture_(o.texture_), atlas_(std::move(o.atlas_)) {
+sg::CollisionMask const *sg::Atlas::mask(TexturePath const &tile) const {
+  auto const it{masks_.find(tile.path)};
+  return it == masks_.end() ? nullptr : &it->second;
+}
+
+sg::Atlas::Atlas(sg::Atlas &&o) noexcept
+        : texture_(o.texture_), atlas_(std::move(o.atlas_)), masks_(std::move(o.masks_)) {
 
 }
 
 sg::Atlas &sg::Atlas::operator=(sg::Atlas &&o) noexcept {
   std::swap(texture_, o.texture_);
   atlas_.swap(o.atlas_);
+  masks_.swap(o.masks_);
   return *this;
 }
 
-sg::Atlas::Atlas(sg::SDLTexture &_texture, sg::Atlas::AtlasMap _atlas)
-        : texture_{&_texture}, atlas_{std::move(_atlas)} {
+sg::Atlas::Atlas(sg::SDLTexture &_texture, sg::Atlas::AtlasMap _atlas, MaskMap _masks)
+        : texture_{&_texture}, atlas_{std::move(_atlas)}, masks_{std::move(_masks)} {
 }
 
-sg::AtlasCache::AtlasCache(TextureCache &_textures) noexcept: textures_{_textures}, atlases_{} {
+sg::AtlasCache::AtlasCache(AssetPack const &_assets, TextureCache &_textures) noexcept
+        : assets_{_assets}, textures_{_textures}, atlases_{} {
 
 }
 
@@ -62,7 +92,17 @@ sg::Atlas &sg::AtlasCache::get(const sg::AtlasDescriptor &d) {
   for (AtlasPair &p : this->atlases_)
     if (p.first == d)
       return p.second;
-  Atlas new_atlas{Atlas::from_descriptor(this->textures_, d)};
+  Atlas new_atlas{Atlas::from_descriptor(this->assets_, this->textures_, d)};
   this->atlases_.emplace_back(d, std::move(new_atlas));
   return this->atlases_.back().second;
 }
+
+bool sg::AtlasCache::replace_tiles(std::filesystem::path const &path, Atlas::Tiles const &tiles) {
+  bool result{false};
+  for (AtlasPair &p : this->atlases_)
+    if (p.first.path == path && !p.first.animation.has_value()) {
+      p.second.replace_tiles(tiles);
+      result = true;
+    }
+  return result;
+}
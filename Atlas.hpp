@@ -7,6 +7,7 @@
 #include <vector>
 #include "TextureCache.hpp"
 #include "TexturePath.hpp"
+#include "CollisionMask.hpp"
 
 namespace sg {
 using AnimationDuration = std::chrono::milliseconds;
@@ -41,8 +42,14 @@ public:
 class Atlas {
 public:
   using AtlasMap = std::map<std::string, IntRectangle>;
+  using MaskMap = std::map<std::string, CollisionMask>;
 
-  Atlas(SDLTexture &, AtlasMap);
+  struct Tiles {
+    AtlasMap atlas;
+    MaskMap masks;
+  };
+
+  Atlas(SDLTexture &, AtlasMap, MaskMap = {});
 
   Atlas(Atlas const &) = delete;
 
@@ -52,21 +59,37 @@ public:
 
   Atlas &operator=(Atlas &&) noexcept;
 
-  static Atlas from_descriptor(TextureCache &textures, AtlasDescriptor const &);
+  // Pins the atlas texture in the cache; atlases live as long as the cache.
+  static Atlas from_descriptor(AssetPack const &, TextureCache &textures, AtlasDescriptor const &);
+
+  // Reads the tile rectangles from the descriptor's JSON and builds their
+  // masks from `image`; safe to call from any thread.
+  static Tiles load_tiles(AssetPack const &, AtlasDescriptor const &, SDLSurface &image);
+
+  void replace_tiles(Tiles);
 
   void render_tile(SDLRenderer &renderer, TexturePath const &, IntRectangle const &) const;
 
+  // Built from the tile's alpha channel; only available for packed (not
+  // animation) atlases.
+  [[nodiscard]] CollisionMask const *mask(TexturePath const &) const;
+
 private:
   SDLTexture *texture_;
   AtlasMap atlas_;
+  MaskMap masks_;
 };
 
 class AtlasCache {
 public:
-  explicit AtlasCache(TextureCache &) noexcept;
+  AtlasCache(AssetPack const &, TextureCache &) noexcept;
 
   Atlas &get(AtlasDescriptor const &);
 
+  // Replaces the tiles of loaded packed atlases using the texture at `path`.
+  // Returns false if there are none.
+  bool replace_tiles(std::filesystem::path const &path, Atlas::Tiles const &);
+
   AtlasCache &operator=(AtlasCache const &) = delete;
 
   AtlasCache(AtlasCache const &) = delete;
@@ -77,6 +100,7 @@ public:
 
 private:
   using AtlasPair = std::pair<AtlasDescriptor, Atlas>;
+  AssetPack const &assets_;
   TextureCache &textures_;
   std::vector<AtlasPair> atlases_;
 };
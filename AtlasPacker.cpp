@@ -0,0 +1,112 @@
+#include "AtlasPacker.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace {
+bool overlaps(sg::IntRectangle const &a, sg::IntRectangle const &b) {
+  return a.left() < b.right() && b.left() < a.right() && a.top() < b.bottom() && b.top() < a.bottom();
+}
+
+bool contains(sg::IntRectangle const &outer, sg::IntRectangle const &inner) {
+  return outer.left() <= inner.left() && inner.right() <= outer.right() && outer.top() <= inner.top()
+         && inner.bottom() <= outer.bottom();
+}
+
+std::optional<sg::PackedAtlas> pack_into(std::vector<sg::IntVector> const &sprites,
+                                         std::vector<std::size_t> const &order,
+                                         sg::IntVector const &size,
+                                         int const padding,
+                                         int const extrude) {
+  sg::AtlasPacker packer{size};
+  std::vector<sg::IntRectangle> frames(sprites.size(), sg::IntRectangle{0, 0, 0, 0});
+  for (std::size_t const i : order) {
+    auto const cell{packer.insert(sprites[i] + sg::IntVector{2 * extrude + padding, 2 * extrude + padding})};
+    if (!cell.has_value())
+      return std::nullopt;
+    frames[i] = sg::IntRectangle::from_pos_and_size(cell->position() + sg::IntVector{extrude, extrude}, sprites[i]);
+  }
+  return sg::PackedAtlas{size, std::move(frames)};
+}
+}
+
+sg::AtlasPacker::AtlasPacker(IntVector const &_size) : free_{IntRectangle::from_size_at_origin(_size)} {}
+
+std::optional<sg::IntRectangle> sg::AtlasPacker::insert(IntVector const &size) {
+  std::optional<IntRectangle> best;
+  auto best_short{std::numeric_limits<int>::max()};
+  auto best_long{std::numeric_limits<int>::max()};
+  for (IntRectangle const &f : free_) {
+    if (f.w() < size.x() || f.h() < size.y())
+      continue;
+    auto const leftover_x{f.w() - size.x()};
+    auto const leftover_y{f.h() - size.y()};
+    auto const short_side{std::min(leftover_x, leftover_y)};
+    auto const long_side{std::max(leftover_x, leftover_y)};
+    if (short_side < best_short || (short_side == best_short && long_side < best_long)) {
+      best = IntRectangle::from_pos_and_size(f.position(), size);
+      best_short = short_side;
+      best_long = long_side;
+    }
+  }
+  if (best.has_value()) {
+    split_free(best.value());
+    prune_free();
+  }
+  return best;
+}
+
+void sg::AtlasPacker::split_free(IntRectangle const &used) {
+  std::vector<IntRectangle> result;
+  for (IntRectangle const &f : free_) {
+    if (!overlaps(f, used)) {
+      result.push_back(f);
+      continue;
+    }
+    if (used.left() > f.left())
+      result.emplace_back(f.left(), used.left(), f.top(), f.bottom());
+    if (used.right() < f.right())
+      result.emplace_back(used.right(), f.right(), f.top(), f.bottom());
+    if (used.top() > f.top())
+      result.emplace_back(f.left(), f.right(), f.top(), used.top());
+    if (used.bottom() < f.bottom())
+      result.emplace_back(f.left(), f.right(), used.bottom(), f.bottom());
+  }
+  free_ = std::move(result);
+}
+
+void sg::AtlasPacker::prune_free() {
+  std::vector<bool> redundant(free_.size(), false);
+  for (std::size_t i{0}; i < free_.size(); ++i)
+    for (std::size_t j{0}; j < free_.size() && !redundant[i]; ++j)
+      if (i != j && !redundant[j] && contains(free_[j], free_[i]))
+        redundant[i] = true;
+  std::vector<IntRectangle> result;
+  for (std::size_t i{0}; i < free_.size(); ++i)
+    if (!redundant[i])
+      result.push_back(free_[i]);
+  free_ = std::move(result);
+}
+
+std::optional<sg::PackedAtlas> sg::pack_atlas(std::vector<IntVector> const &sprites, int const padding,
+                                              int const extrude, int const max_size) {
+  // Big sprites first leave the small ones to fill the gaps
+  std::vector<std::size_t> order(sprites.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&sprites](std::size_t const a, std::size_t const b) {
+    return std::max(sprites[a].x(), sprites[a].y()) > std::max(sprites[b].x(), sprites[b].y());
+  });
+  long area{0};
+  for (IntVector const &s : sprites)
+    area += static_cast<long>(s.x() + 2 * extrude + padding) * (s.y() + 2 * extrude + padding);
+  IntVector size{1, 1};
+  while (static_cast<long>(size.x()) * size.y() < area)
+    size = size.x() <= size.y() ? IntVector{size.x() * 2, size.y()} : IntVector{size.x(), size.y() * 2};
+  while (size.x() <= max_size && size.y() <= max_size) {
+    if (auto packed{pack_into(sprites, order, size, padding, extrude)})
+      return packed;
+    size = size.x() <= size.y() ? IntVector{size.x() * 2, size.y()} : IntVector{size.x(), size.y() * 2};
+  }
+  return std::nullopt;
+}
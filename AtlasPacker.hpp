@@ -0,0 +1,36 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+#include "math.hpp"
+
+namespace sg {
+// MaxRects bin packing into a fixed-size area, placing each rectangle where
+// it leaves the shortest leftover side.
+class AtlasPacker {
+public:
+  explicit AtlasPacker(IntVector const &size);
+
+  std::optional<IntRectangle> insert(IntVector const &size);
+
+private:
+  std::vector<IntRectangle> free_;
+
+  void split_free(IntRectangle const &used);
+
+  void prune_free();
+};
+
+struct PackedAtlas {
+  // The power of two size packed into, unused space included
+  IntVector size;
+  // Where each sprite goes, in input order, without padding and extrusion
+  std::vector<IntRectangle> frames;
+};
+
+// Packs the sprites into the smallest atlas (trying power of two sizes up
+// to `max_size` on each side) that fits them all. Each sprite is surrounded
+// by `extrude` pixels of its repeated border and `padding` pixels of empty
+// space.
+std::optional<PackedAtlas> pack_atlas(std::vector<IntVector> const &sprites, int padding, int extrude, int max_size);
+}
@@ -0,0 +1,139 @@
+#include "AudioMixer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+// acc[i] += src[i] * gain, with the gains alternating left/right
+void accumulate(float *acc, float const *src, std::size_t const frames, float const gain_left, float const gain_right) {
+  std::size_t const n{frames * 2};
+  std::size_t i{0};
+#if defined(__AVX__)
+  __m256 const gain{_mm256_setr_ps(gain_left, gain_right, gain_left, gain_right,
+                                   gain_left, gain_right, gain_left, gain_right)};
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), gain)));
+#elif defined(__SSE2__)
+  __m128 const gain{_mm_setr_ps(gain_left, gain_right, gain_left, gain_right)};
+  for (; i + 4 <= n; i += 4)
+    _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(src + i), gain)));
+#endif
+  for (; i < n; i += 2) {
+    acc[i] += src[i] * gain_left;
+    acc[i + 1] += src[i + 1] * gain_right;
+  }
+}
+
+// out[i] = saturate(out[i] + acc[i] * 32767)
+void add_to_s16(std::int16_t *out, float const *acc, std::size_t const n) {
+  std::size_t i{0};
+#if defined(__SSE2__)
+  __m128 const scale{_mm_set1_ps(32767.0f)};
+  for (; i + 8 <= n; i += 8) {
+    __m128i const existing{_mm_loadu_si128(reinterpret_cast<__m128i const *>(out + i))};
+    // Sign-extend the 16 bit samples to 32 bit
+    __m128 const low{_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(existing, existing), 16))};
+    __m128 const high{_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(existing, existing), 16))};
+    __m128i const mixed_low{_mm_cvtps_epi32(_mm_add_ps(low, _mm_mul_ps(_mm_loadu_ps(acc + i), scale)))};
+    __m128i const mixed_high{_mm_cvtps_epi32(_mm_add_ps(high, _mm_mul_ps(_mm_loadu_ps(acc + i + 4), scale)))};
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(mixed_low, mixed_high));
+  }
+#endif
+  for (; i < n; ++i) {
+    auto const mixed{std::lround(static_cast<float>(out[i]) + acc[i] * 32767.0f)};
+    out[i] = static_cast<std::int16_t>(std::clamp<long>(mixed, std::numeric_limits<std::int16_t>::min(),
+                                                        std::numeric_limits<std::int16_t>::max()));
+  }
+}
+}
+
+sg::MixerSound sg::MixerSound::from_s16(std::int16_t const *samples, std::size_t const frames, int const channels) {
+  std::vector<float> stereo(frames * 2);
+  for (std::size_t i{0}; i < frames; ++i) {
+    auto const *const frame{samples + i * static_cast<std::size_t>(channels)};
+    stereo[i * 2] = static_cast<float>(frame[0]) / 32768.0f;
+    stereo[i * 2 + 1] = static_cast<float>(frame[channels > 1 ? 1 : 0]) / 32768.0f;
+  }
+  return MixerSound{std::move(stereo)};
+}
+
+sg::AudioMixer::AudioMixer()
+        : commands_{},
+          voices_{},
+          voice_count_{0},
+          accumulator_{},
+          next_id_{0},
+          active_voices_{0},
+          stolen_voices_{0} {}
+
+std::optional<sg::VoiceId> sg::AudioMixer::play(MixerSound const &sound, float const gain, float const pan) {
+  // Constant power panning
+  float const angle{(std::clamp(pan, -1.0f, 1.0f) + 1.0f) * 0.25f * 3.14159265f};
+  VoiceId const id{next_id_};
+  if (!commands_.push(Command{Command::Type::Play, id, &sound, gain * std::cos(angle), gain * std::sin(angle)}))
+    return std::nullopt;
+  ++next_id_;
+  return id;
+}
+
+void sg::AudioMixer::stop(VoiceId const id) {
+  commands_.push(Command{Command::Type::Stop, id, nullptr, 0.0f, 0.0f});
+}
+
+void sg::AudioMixer::mix(std::int16_t *out, std::size_t frames) {
+  run_commands();
+  while (frames > 0) {
+    std::size_t const block{std::min(frames, block_frames)};
+    std::fill(accumulator_.begin(), accumulator_.begin() + static_cast<std::ptrdiff_t>(block * 2), 0.0f);
+    for (std::size_t v{0}; v < voice_count_;) {
+      Voice &voice{voices_[v]};
+      std::size_t const n{std::min(block, voice.sound->frames() - voice.position)};
+      accumulate(accumulator_.data(), voice.sound->samples() + voice.position * 2, n, voice.gain_left, voice.gain_right);
+      voice.position += n;
+      if (voice.position == voice.sound->frames())
+        remove_voice(v);
+      else
+        ++v;
+    }
+    add_to_s16(out, accumulator_.data(), block * 2);
+    out += block * 2;
+    frames -= block;
+  }
+  active_voices_.store(voice_count_, std::memory_order_relaxed);
+}
+
+void sg::AudioMixer::run_commands() {
+  while (auto const command{commands_.pop()}) {
+    if (command->type == Command::Type::Stop) {
+      for (std::size_t v{0}; v < voice_count_; ++v)
+        if (voices_[v].id == command->id) {
+          remove_voice(v);
+          break;
+        }
+      continue;
+    }
+    if (command->sound->frames() == 0)
+      continue;
+    Voice const voice{command->id, command->sound, 0, command->gain_left, command->gain_right};
+    if (voice_count_ < max_voices) {
+      voices_[voice_count_++] = voice;
+      continue;
+    }
+    // All voices busy: cut the one closest to its end
+    auto const remaining = [](Voice const &v) { return v.sound->frames() - v.position; };
+    auto const victim{std::min_element(voices_.begin(), voices_.end(), [&remaining](Voice const &a, Voice const &b) {
+      return remaining(a) < remaining(b);
+    })};
+    *victim = voice;
+    stolen_voices_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void sg::AudioMixer::remove_voice(std::size_t const v) {
+  voices_[v] = voices_[--voice_count_];
+}
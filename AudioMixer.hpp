@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "spsc_queue.hpp"
+#include "util.hpp"
+
+namespace sg {
+// Interleaved stereo samples in [-1, 1]
+class MixerSound {
+public:
+  explicit MixerSound(std::vector<float> stereo) : samples_{std::move(stereo)} {}
+
+  // Converts signed 16 bit samples; mono is duplicated to both sides, any
+  // channels beyond the second are dropped.
+  static MixerSound from_s16(std::int16_t const *, std::size_t frames, int channels);
+
+  [[nodiscard]] std::size_t frames() const { return samples_.size() / 2; }
+
+  [[nodiscard]] float const *samples() const { return samples_.data(); }
+
+private:
+  std::vector<float> samples_;
+};
+
+using VoiceId = std::uint32_t;
+
+// Mixes many voices into a signed 16 bit stereo stream. play()/stop() are
+// called from the game thread and only enqueue commands; mix() runs on the
+// audio thread and neither locks nor allocates. Sounds must outlive the
+// voices playing them.
+class AudioMixer {
+public:
+  static constexpr std::size_t max_voices{256};
+
+  AudioMixer();
+
+  SG_NONCOPYABLE(AudioMixer);
+  SG_NONMOVEABLE(AudioMixer);
+
+  // `pan` goes from -1 (left) to 1 (right). Nothing if the command queue is
+  // full.
+  std::optional<VoiceId> play(MixerSound const &, float gain = 1.0f, float pan = 0.0f);
+
+  void stop(VoiceId);
+
+  // Adds the voices to the samples already in `out`, saturating.
+  void mix(std::int16_t *out, std::size_t frames);
+
+  [[nodiscard]] std::size_t active_voices() const { return active_voices_.load(std::memory_order_relaxed); }
+
+  // Voices cut short because all were in use
+  [[nodiscard]] std::uint64_t stolen_voices() const { return stolen_voices_.load(std::memory_order_relaxed); }
+
+private:
+  static constexpr std::size_t block_frames{512};
+
+  struct Command {
+    enum class Type {
+      Play, Stop
+    } type;
+    VoiceId id;
+    MixerSound const *sound;
+    float gain_left;
+    float gain_right;
+  };
+
+  struct Voice {
+    VoiceId id;
+    MixerSound const *sound;
+    std::size_t position;
+    float gain_left;
+    float gain_right;
+  };
+
+  SpscQueue<Command, 1024> commands_;
+  // Playing voices are kept at the front
+  std::array<Voice, max_voices> voices_;
+  std::size_t voice_count_;
+  std::array<float, block_frames * 2> accumulator_;
+  VoiceId next_id_;
+  std::atomic<std::size_t> active_voices_;
+  std::atomic<std::uint64_t> stolen_voices_;
+
+  void run_commands();
+
+  void remove_voice(std::size_t);
+};
+}
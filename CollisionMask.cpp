@@ -0,0 +1,71 @@
+#include "CollisionMask.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+std::uint8_t const alpha_threshold{128};
+int const word_bits{64};
+
+int words_for(int const width) {
+  return (width + word_bits - 1) / word_bits;
+}
+}
+
+sg::CollisionMask::CollisionMask(IntVector const &_size, std::vector<Word> _bits)
+        : size_{_size}, words_per_row_{words_for(_size.x())}, bits_{std::move(_bits)} {
+  if (bits_.size() != static_cast<std::size_t>(words_per_row_ * size_.y()))
+    throw std::runtime_error{"collision mask bit count doesn't match its size"};
+}
+
+sg::CollisionMask sg::CollisionMask::from_alpha(SDL_Surface const *s, IntRectangle const &r) {
+  if (s->format->BytesPerPixel != 4 || s->format->Amask == 0)
+    throw std::runtime_error{"collision masks need a 32 bit surface with alpha"};
+  int const words_per_row{words_for(r.w())};
+  std::vector<Word> bits(static_cast<std::size_t>(words_per_row * r.h()), 0);
+  for (int y{0}; y < r.h(); ++y) {
+    auto const *const row{reinterpret_cast<Uint32 const *>(
+                                  static_cast<Uint8 const *>(s->pixels) + (r.top() + y) * s->pitch) + r.left()};
+    for (int x{0}; x < r.w(); ++x)
+      if (((row[x] & s->format->Amask) >> s->format->Ashift) >= alpha_threshold)
+        bits[static_cast<std::size_t>(y * words_per_row + x / word_bits)] |= Word{1} << (x % word_bits);
+  }
+  return CollisionMask{r.size(), std::move(bits)};
+}
+
+sg::CollisionMask sg::CollisionMask::scaled(IntVector const &new_size) const {
+  int const words_per_row{words_for(new_size.x())};
+  std::vector<Word> bits(static_cast<std::size_t>(words_per_row * new_size.y()), 0);
+  for (int y{0}; y < new_size.y(); ++y)
+    for (int x{0}; x < new_size.x(); ++x)
+      if (test(x * size_.x() / new_size.x(), y * size_.y() / new_size.y()))
+        bits[static_cast<std::size_t>(y * words_per_row + x / word_bits)] |= Word{1} << (x % word_bits);
+  return CollisionMask{new_size, std::move(bits)};
+}
+
+bool sg::CollisionMask::test(int const x, int const y) const {
+  return (bits_[static_cast<std::size_t>(y * words_per_row_ + x / word_bits)] >> (x % word_bits)) & 1u;
+}
+
+sg::CollisionMask::Word sg::CollisionMask::row_bits(int const y, int const x, int const count) const {
+  auto const row{bits_.begin() + y * words_per_row_};
+  int const word{x / word_bits};
+  int const shift{x % word_bits};
+  Word result{row[word] >> shift};
+  if (shift != 0 && word + 1 < words_per_row_)
+    result |= row[word + 1] << (word_bits - shift);
+  return count >= word_bits ? result : result & ((Word{1} << count) - 1);
+}
+
+bool sg::masks_overlap(CollisionMask const &a, IntVector const &a_pos, CollisionMask const &b, IntVector const &b_pos) {
+  int const left{std::max(a_pos.x(), b_pos.x())};
+  int const right{std::min(a_pos.x() + a.size().x(), b_pos.x() + b.size().x())};
+  int const top{std::max(a_pos.y(), b_pos.y())};
+  int const bottom{std::min(a_pos.y() + a.size().y(), b_pos.y() + b.size().y())};
+  for (int y{top}; y < bottom; ++y)
+    for (int x{left}; x < right; x += word_bits) {
+      int const count{std::min(word_bits, right - x)};
+      if ((a.row_bits(y - a_pos.y(), x - a_pos.x(), count) & b.row_bits(y - b_pos.y(), x - b_pos.x(), count)) != 0)
+        return true;
+    }
+  return false;
+}
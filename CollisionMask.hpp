@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <SDL.h>
+#include "math.hpp"
+
+namespace sg {
+// One bit per pixel, set where the sprite is opaque enough to collide.
+// Rows are stored as 64 bit words so overlaps are tested a word at a time.
+class CollisionMask {
+public:
+  using Word = std::uint64_t;
+
+  CollisionMask(IntVector const &size, std::vector<Word> bits);
+
+  // Expects a 32 bit surface with an alpha channel.
+  static CollisionMask from_alpha(SDL_Surface const *, IntRectangle const &);
+
+  [[nodiscard]] CollisionMask scaled(IntVector const &) const;
+
+  [[nodiscard]] IntVector size() const { return size_; }
+
+  [[nodiscard]] bool test(int x, int y) const;
+
+  // 64 (or fewer) bits of a row starting at x
+  [[nodiscard]] Word row_bits(int y, int x, int count) const;
+
+private:
+  IntVector size_;
+  int words_per_row_;
+  std::vector<Word> bits_;
+};
+
+// Whether the masks, placed with their top-left corners at the given
+// positions, have an opaque pixel in common.
+bool masks_overlap(CollisionMask const &, IntVector const &, CollisionMask const &, IntVector const &);
+}
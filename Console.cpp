@@ -10,15 +10,20 @@ std::string format_hms(sg::Clock::time_point const &t) {
 }
 }
 
-sg::Console::Console() : lines_{}, toggled_{false} {
+sg::Console::Console() : lines_{}, toggled_{false}, revision_{0} {
 }
 
 void sg::Console::toggle() {
   this->toggled_ = !this->toggled_;
+  revision_++;
 }
 
 void sg::Console::add_line(const std::string &l, bool const date) {
-  this->lines_.push_back(date ? (format_hms(Clock::now())+": ")+l : l);
+  std::string const line{date ? (format_hms(Clock::now())+": ")+l : l};
+  this->lines_.emplace_back(line.begin(), line.end());
+  // Lines added while hidden change nothing on screen
+  if (toggled_)
+    revision_++;
 }
 
 sg::RenderObjectList sg::Console::draw() const {
@@ -31,6 +36,6 @@ sg::RenderObjectList sg::Console::draw() const {
   std::size_t const line_count{game_size.y() / 2 / console_font.size + 1};
   std::size_t i{0};
   for (LineVector::const_reverse_iterator it{this->lines_.crbegin()}; i < std::min(line_count, this->lines_.size()); ++i, ++it)
-    result.push_back(sg::Text{console_font, *it, sg::IntVector{0, static_cast<int>(game_size.y() / 2 - (i+1) * console_font.size)}, console_font_color});
+    result.push_back(sg::Text{console_font, std::string{it->begin(), it->end()}, sg::IntVector{0, static_cast<int>(game_size.y() / 2 - (i+1) * console_font.size)}, console_font_color});
   return result;
 }
@@ -1,13 +1,16 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include "RenderObject.hpp"
+#include "memory_tracking.hpp"
 
 namespace sg {
 class Console {
 public:
-  using LineVector = std::vector<std::string>;
+  using Line = std::basic_string<char, std::char_traits<char>, TaggedAllocator<char, MemoryTag::Console>>;
+  using LineVector = TaggedVector<Line, MemoryTag::Console>;
 
   Console();
 
@@ -17,8 +20,12 @@ public:
 
   void add_line(std::string const &, bool with_date);
 
+  // Changes whenever draw() would return something different
+  [[nodiscard]] std::uint64_t revision() const { return revision_; }
+
 private:
   LineVector lines_;
   bool toggled_;
+  std::uint64_t revision_;
 };
 }
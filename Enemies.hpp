@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include "TexturePath.hpp"
+#include "types.hpp"
+
+namespace sg {
+enum class EnemyType : unsigned {
+  AsteroidMedium, AsteroidBig, AsteroidSmall, EnemyShip, Ufo
+};
+
+// Behaviour parameters per enemy type. Everything is a compile-time
+// constant so the update kernel for a type has no per-entity branching.
+template<EnemyType>
+struct EnemyTraits;
+
+template<>
+struct EnemyTraits<EnemyType::AsteroidMedium> {
+  static constexpr char const *texture{"meteorBrown_med1.png"};
+  static constexpr int width{42}, height{42};
+  static constexpr Health health{50};
+  static constexpr double speed_x{0}, speed_y{200};
+  static constexpr double sway_amplitude{0}, sway_wavelength{1};
+};
+
+template<>
+struct EnemyTraits<EnemyType::AsteroidBig> {
+  static constexpr char const *texture{"meteorBrown_big1.png"};
+  static constexpr int width{50}, height{42};
+  static constexpr Health health{200};
+  static constexpr double speed_x{0}, speed_y{120};
+  static constexpr double sway_amplitude{0}, sway_wavelength{1};
+};
+
+template<>
+struct EnemyTraits<EnemyType::AsteroidSmall> {
+  static constexpr char const *texture{"meteorGrey_small1.png"};
+  static constexpr int width{20}, height{20};
+  static constexpr Health health{50};
+  static constexpr double speed_x{40}, speed_y{260};
+  static constexpr double sway_amplitude{0}, sway_wavelength{1};
+};
+
+template<>
+struct EnemyTraits<EnemyType::EnemyShip> {
+  static constexpr char const *texture{"enemyBlack1.png"};
+  static constexpr int width{46}, height{42};
+  static constexpr Health health{100};
+  static constexpr double speed_x{0}, speed_y{150};
+  static constexpr double sway_amplitude{80}, sway_wavelength{60};
+};
+
+template<>
+struct EnemyTraits<EnemyType::Ufo> {
+  static constexpr char const *texture{"ufoGreen.png"};
+  static constexpr int width{45}, height{45};
+  static constexpr Health health{300};
+  static constexpr double speed_x{0}, speed_y{90};
+  static constexpr double sway_amplitude{160}, sway_wavelength{120};
+};
+
+template<EnemyType... Types>
+struct EnemyTypeList {
+  static constexpr std::size_t size{sizeof...(Types)};
+};
+
+// Adding an enemy kind means adding its traits and listing it here.
+using EnemyRegistry = EnemyTypeList<EnemyType::AsteroidMedium,
+        EnemyType::AsteroidBig,
+        EnemyType::AsteroidSmall,
+        EnemyType::EnemyShip,
+        EnemyType::Ufo>;
+
+std::size_t constexpr enemy_type_count{EnemyRegistry::size};
+
+template<EnemyType... Types, typename F>
+void for_each_enemy_type(EnemyTypeList<Types...>, F const &f) {
+  (f(std::integral_constant<EnemyType, Types>{}), ...);
+}
+
+template<typename F>
+void for_each_enemy_type(F const &f) {
+  for_each_enemy_type(EnemyRegistry{}, f);
+}
+
+struct EnemyInfo {
+  char const *texture;
+  int width;
+  int height;
+  Health health;
+};
+
+template<EnemyType... Types>
+constexpr std::array<EnemyInfo, sizeof...(Types)> make_enemy_info(EnemyTypeList<Types...>) {
+  std::array<EnemyInfo, sizeof...(Types)> result{};
+  ((result[static_cast<std::size_t>(Types)] = EnemyInfo{EnemyTraits<Types>::texture,
+                                                       EnemyTraits<Types>::width,
+                                                       EnemyTraits<Types>::height,
+                                                       EnemyTraits<Types>::health}), ...);
+  return result;
+}
+
+// Runtime view of the traits, for code that only has an EnemyType value.
+inline constexpr std::array<EnemyInfo, enemy_type_count> enemy_info_table{make_enemy_info(EnemyRegistry{})};
+
+inline EnemyInfo const &enemy_info(EnemyType const t) {
+  return enemy_info_table[static_cast<std::size_t>(t)];
+}
+
+inline TexturePath enemy_texture(EnemyType const t) {
+  return TexturePath{enemy_info(t).texture};
+}
+
+// Moves every enemy in a bucket of type T. Swaying types move along a sine
+// over their vertical position, so no per-entity state is needed.
+template<EnemyType T, typename Enemies>
+void move_enemies(Enemies &enemies, double const secs) {
+  using Traits = EnemyTraits<T>;
+  for (auto &e : enemies) {
+    e.previous_position = e.position;
+    double dx{Traits::speed_x * secs};
+    if constexpr (Traits::sway_amplitude != 0.0)
+      dx += Traits::sway_amplitude / Traits::sway_wavelength * Traits::speed_y * secs *
+            std::cos(e.position.y() / Traits::sway_wavelength);
+    e.position += decltype(e.position){dx, Traits::speed_y * secs};
+  }
+}
+}
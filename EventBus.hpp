@@ -0,0 +1,72 @@
+#pragma once
+
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace sg {
+// Typed publish/subscribe for the events of one frame. Every event type has
+// its own queue; publish() only appends, dispatch() hands everything queued
+// to the subscribers of its type, one type after the other in the order of
+// `Events`. Queues keep their capacity, so once warmed up neither side
+// allocates. Events published by subscribers during dispatch() are
+// delivered by the next one.
+template<typename... Events>
+class EventBus {
+public:
+  template<typename E>
+  using Handler = std::function<void(E const &)>;
+
+  template<typename E>
+  void subscribe(Handler<E> handler) {
+    channel<E>().handlers.push_back(std::move(handler));
+  }
+
+  template<typename E>
+  void publish(E const &e) {
+    channel<E>().pending.push_back(e);
+  }
+
+  void dispatch() {
+    std::apply([](auto &... channels) { (deliver(channels), ...); }, channels_);
+  }
+
+  // Drops everything queued without delivering it
+  void discard() {
+    std::apply([](auto &... channels) { (channels.pending.clear(), ...); }, channels_);
+  }
+
+  template<typename E>
+  [[nodiscard]] std::size_t pending() const {
+    return std::get<Channel<E>>(channels_).pending.size();
+  }
+
+private:
+  template<typename E>
+  struct Channel {
+    static_assert(std::is_trivially_copyable_v<E>, "events are copied around freely");
+
+    std::vector<Handler<E>> handlers;
+    std::vector<E> pending;
+    // Swapped with pending while delivering
+    std::vector<E> delivering;
+  };
+
+  std::tuple<Channel<Events>...> channels_;
+
+  template<typename E>
+  Channel<E> &channel() {
+    return std::get<Channel<E>>(channels_);
+  }
+
+  template<typename E>
+  static void deliver(Channel<E> &c) {
+    c.delivering.swap(c.pending);
+    for (E const &e : c.delivering)
+      for (Handler<E> const &h : c.handlers)
+        h(e);
+    c.delivering.clear();
+  }
+};
+}
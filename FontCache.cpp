@@ -1,29 +1,48 @@
 #include "FontCache.hpp"
 
 sg::FontCache::FontCache(SDLTTFContext &_font_context, SDLRenderer &_renderer)
-        : font_context_{_font_context}, renderer_{_renderer}, fonts_{}, texts_{64} {}
+        : font_context_{_font_context}, renderer_{_renderer}, fonts_{}, texts_{64}, hits_{0}, misses_{0} {}
 
 
 void sg::FontCache::copy_text(FontDescriptor const &font, std::string const &text, Color const &color,
                               IntVector const &position) {
-  SDLTexture &texture{this->render_text(font, text, color)};
+  SDLTexture &texture{this->render_text(font, text)};
+  texture.color_mod(color);
   auto const text_size{texture.size()};
   renderer_.copy_whole(texture,
                        IntRectangle::from_pos_and_size(position, text_size));
 }
 
 sg::SDLTexture &
-sg::FontCache::render_text(FontDescriptor const &font, std::string const &text, Color const &color) {
-  TextDescriptor const tdescriptor{font, text, color};
-  if (this->texts_.exists(tdescriptor))
+sg::FontCache::render_text(FontDescriptor const &font, std::string const &text) {
+  TextDescriptor const tdescriptor{font, text};
+  if (this->texts_.exists(tdescriptor)) {
+    hits_++;
     return this->texts_.get(tdescriptor);
+  }
+  misses_++;
   SDLTTFFont &existing_font{map_insert_or_load(this->fonts_,
                                                font,
                                                [this, &font]() {
                                                  return font_context_.open_font(font.path,
                                                                                 font.size);
                                                })};
-  SDLSurface surface{existing_font.render_blended(text, color)};
+  SDLSurface surface{existing_font.render_blended(text, SDL_Color{255, 255, 255, 255})};
   SDLTexture texture{this->renderer_.create_texture(surface)};
   return texts_.put(tdescriptor, std::move(texture));
 }
+
+bool sg::FontCache::reload(std::filesystem::path const &p) {
+  bool result{false};
+  for (FontMap::iterator it{fonts_.begin()}; it != fonts_.end();) {
+    if (it->first.path == p) {
+      it = fonts_.erase(it);
+      result = true;
+    } else {
+      ++it;
+    }
+  }
+  if (result)
+    texts_.clear();
+  return result;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <map>
 #include <filesystem>
 #include "SDL.hpp"
@@ -7,12 +8,14 @@
 #include "util.hpp"
 #include "types.hpp"
 #include "lru.hpp"
+#include "memory_tracking.hpp"
 
 namespace sg {
+// Text is rendered white once and tinted when copied, so one texture
+// serves every color.
 struct TextDescriptor {
   FontDescriptor font;
   std::string text;
-  Color color;
 
   bool operator<(TextDescriptor const &o) const {
     return std::make_tuple(font, text) < std::make_tuple(o.font, o.text);
@@ -21,22 +24,37 @@ struct TextDescriptor {
 
 class FontCache {
 private:
-  using FontMap = std::map<FontDescriptor, SDLTTFFont>;
-  using TextMap = LRU<TextDescriptor, SDLTexture>;
+  template<typename T>
+  using Allocator = TaggedAllocator<T, MemoryTag::Fonts>;
+  using FontMap = std::map<FontDescriptor, SDLTTFFont, std::less<FontDescriptor>, Allocator<std::pair<FontDescriptor const, SDLTTFFont>>>;
+  using TextMap = LRU<TextDescriptor, SDLTexture, Allocator>;
 
 public:
+  using Counter = std::uint64_t;
+
   FontCache(SDLTTFContext &, SDLRenderer &);
 
   void copy_text(FontDescriptor const &, std::string const &, Color const &, IntVector const &);
 
+  // Closes every size of the font file and drops all rendered text; the
+  // font is reopened on next use. Returns false if the font wasn't open.
+  bool reload(std::filesystem::path const &);
+
+  // Lookups of rendered text
+  [[nodiscard]] Counter hits() const { return hits_; }
+
+  [[nodiscard]] Counter misses() const { return misses_; }
+
 private:
   sg::SDLTTFContext &font_context_;
   sg::SDLRenderer &renderer_;
   FontMap fonts_;
   TextMap texts_;
+  Counter hits_;
+  Counter misses_;
 
   sg::SDLTexture &
-  render_text(FontDescriptor const &, std::string const &, Color const &);
+  render_text(FontDescriptor const &, std::string const &);
 };
 }
 
@@ -0,0 +1,212 @@
+#include "FrameCapture.hpp"
+#include <array>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+void put_u32_be(std::vector<std::uint8_t> &out, std::uint32_t const v) {
+  for (int const shift : {24, 16, 8, 0})
+    out.push_back(static_cast<std::uint8_t>(v >> shift));
+}
+
+// The "Quite OK Image" format, RGB only, since frames read back from the
+// window have no meaningful alpha
+std::vector<std::uint8_t> encode_qoi(Uint32 const *const pixels, sg::IntVector const &size) {
+  std::size_t const count{static_cast<std::size_t>(size.x()) * static_cast<std::size_t>(size.y())};
+  std::vector<std::uint8_t> out;
+  out.reserve(14 + count * 2 + 8);
+  for (char const c : {'q', 'o', 'i', 'f'})
+    out.push_back(static_cast<std::uint8_t>(c));
+  put_u32_be(out, static_cast<std::uint32_t>(size.x()));
+  put_u32_be(out, static_cast<std::uint32_t>(size.y()));
+  out.push_back(3);
+  out.push_back(0);
+
+  std::array<Uint32, 64> seen{};
+  Uint32 previous{0xff000000};
+  int run{0};
+  for (std::size_t i{0}; i < count; ++i) {
+    Uint32 const p{pixels[i] | 0xff000000};
+    if (p == previous) {
+      if (++run == 62) {
+        out.push_back(static_cast<std::uint8_t>(0xc0 | (run - 1)));
+        run = 0;
+      }
+      continue;
+    }
+    if (run > 0) {
+      out.push_back(static_cast<std::uint8_t>(0xc0 | (run - 1)));
+      run = 0;
+    }
+    int const r{static_cast<int>((p >> 16) & 0xff)};
+    int const g{static_cast<int>((p >> 8) & 0xff)};
+    int const b{static_cast<int>(p & 0xff)};
+    auto const index{static_cast<std::size_t>((r * 3 + g * 5 + b * 7 + 255 * 11) % 64)};
+    if (seen[index] == p) {
+      out.push_back(static_cast<std::uint8_t>(index));
+    } else {
+      seen[index] = p;
+      // Channel differences wrap around, as in the reference encoder
+      auto const wrap = [](int const d) { return static_cast<int>(static_cast<std::int8_t>(d)); };
+      int const dr{wrap(r - static_cast<int>((previous >> 16) & 0xff))};
+      int const dg{wrap(g - static_cast<int>((previous >> 8) & 0xff))};
+      int const db{wrap(b - static_cast<int>(previous & 0xff))};
+      int const dr_dg{dr - dg};
+      int const db_dg{db - dg};
+      if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+        out.push_back(static_cast<std::uint8_t>(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+      } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+        out.push_back(static_cast<std::uint8_t>(0x80 | (dg + 32)));
+        out.push_back(static_cast<std::uint8_t>((dr_dg + 8) << 4 | (db_dg + 8)));
+      } else {
+        out.push_back(0xfe);
+        out.push_back(static_cast<std::uint8_t>(r));
+        out.push_back(static_cast<std::uint8_t>(g));
+        out.push_back(static_cast<std::uint8_t>(b));
+      }
+    }
+    previous = p;
+  }
+  if (run > 0)
+    out.push_back(static_cast<std::uint8_t>(0xc0 | (run - 1)));
+  for (std::uint8_t const c : {0, 0, 0, 0, 0, 0, 0, 1})
+    out.push_back(c);
+  return out;
+}
+
+std::string frame_name(std::uint64_t const frame, sg::CaptureFormat const format) {
+  std::array<char, 32> name{};
+  std::snprintf(name.data(),
+                name.size(),
+                "frame-%06llu.%s",
+                static_cast<unsigned long long>(frame),
+                format == sg::CaptureFormat::Png ? "png" : "qoi");
+  return name.data();
+}
+}
+
+sg::FrameCapture::FrameCapture(SDLImageContext &_image_context, CaptureConfig _config)
+        : image_context_{_image_context},
+          config_{std::move(_config)},
+          buffers_{},
+          next_frame_{0},
+          written_{0},
+          dropped_{0},
+          failed_{0},
+          mutex_{},
+          queued_{},
+          returned_{},
+          free_{},
+          pending_{},
+          first_error_{},
+          stop_{false},
+          workers_{} {
+  std::filesystem::create_directories(config_.directory.value());
+  buffers_.resize(std::max(std::size_t{1}, config_.buffers), Buffer{{}, IntVector{0, 0}, 0});
+  for (std::size_t i{0}; i < buffers_.size(); ++i)
+    free_.push_back(i);
+  for (unsigned i{0}; i < std::max(1u, config_.threads); ++i)
+    workers_.emplace_back([this]() { work(); });
+}
+
+sg::FrameCapture::~FrameCapture() {
+  {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    stop_ = true;
+  }
+  queued_.notify_all();
+  for (std::thread &t : workers_)
+    t.join();
+}
+
+bool sg::FrameCapture::capture(SDLRenderer &renderer) {
+  std::size_t index;
+  {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    if (free_.empty()) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    index = free_.back();
+    free_.pop_back();
+  }
+  // The buffer belongs to this thread until it's queued
+  Buffer &b{buffers_[index]};
+  b.size = renderer.read_pixels(b.pixels);
+  b.frame = next_frame_++;
+  {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    pending_.push_back(index);
+  }
+  queued_.notify_one();
+  return true;
+}
+
+void sg::FrameCapture::flush() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  returned_.wait(lock, [this]() { return free_.size() == buffers_.size(); });
+}
+
+std::optional<std::string> sg::FrameCapture::first_error() const {
+  std::lock_guard<std::mutex> const lock{mutex_};
+  return first_error_;
+}
+
+void sg::FrameCapture::work() {
+  for (;;) {
+    std::size_t index;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      queued_.wait(lock, [this]() { return stop_ || !pending_.empty(); });
+      // Queued frames still get written on the way out
+      if (pending_.empty())
+        return;
+      index = pending_.front();
+      pending_.pop_front();
+    }
+    try {
+      write(buffers_[index]);
+      written_.fetch_add(1, std::memory_order_relaxed);
+    } catch (std::exception const &e) {
+      failed_.fetch_add(1, std::memory_order_relaxed);
+      std::lock_guard<std::mutex> const lock{mutex_};
+      if (!first_error_.has_value())
+        first_error_ = e.what();
+    }
+    {
+      std::lock_guard<std::mutex> const lock{mutex_};
+      free_.push_back(index);
+    }
+    returned_.notify_all();
+  }
+}
+
+void sg::FrameCapture::write(Buffer &b) {
+  std::filesystem::path const path{config_.directory.value() / frame_name(b.frame, config_.format)};
+  if (config_.format == CaptureFormat::Png) {
+    // The pixels stay ours; SDL only borrows them
+    SDLSurface surface{SDL_CreateRGBSurfaceWithFormatFrom(b.pixels.data(),
+                                                          b.size.x(),
+                                                          b.size.y(),
+                                                          32,
+                                                          b.size.x() * static_cast<int>(sizeof(Uint32)),
+                                                          SDL_PIXELFORMAT_RGB888)};
+    if (surface.surface() == nullptr)
+      throw std::runtime_error{"couldn't wrap captured frame: " + std::string{SDL_GetError()}};
+    image_context_.save_png(surface, path);
+    return;
+  }
+  std::vector<std::uint8_t> const encoded{encode_qoi(b.pixels.data(), b.size)};
+  std::ofstream out{path, std::ios::binary};
+  out.write(reinterpret_cast<char const *>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+  if (!out)
+    throw std::runtime_error{"couldn't write " + path.string()};
+}
+
+std::string sg::format_capture(FrameCapture const &c) {
+  std::string result{"capture: " + std::to_string(c.written()) + " of " + std::to_string(c.frames()) +
+                     " frames written, " + std::to_string(c.dropped()) + " dropped"};
+  if (c.failed() > 0)
+    result += ", " + std::to_string(c.failed()) + " failed (" + c.first_error().value_or("") + ")";
+  return result;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SDL.hpp"
+#include "util.hpp"
+
+namespace sg {
+enum class CaptureFormat {
+  Png,
+  // Encodes several times faster than PNG at a somewhat larger size
+  Qoi
+};
+
+struct CaptureConfig {
+  std::optional<std::filesystem::path> directory;
+  CaptureFormat format{CaptureFormat::Qoi};
+  unsigned threads{2};
+  // Frames read back but not written yet; beyond that frames are dropped
+  std::size_t buffers{6};
+
+  [[nodiscard]] bool enabled() const { return directory.has_value(); }
+};
+
+// Records frames as numbered images. The game thread only reads the frame
+// back into a buffer from a reused pool; encoding and writing happen on
+// background threads. With no free buffer the frame is dropped, never
+// waited for.
+class FrameCapture {
+public:
+  FrameCapture(SDLImageContext &, CaptureConfig);
+
+  SG_NONCOPYABLE(FrameCapture);
+  SG_NONMOVEABLE(FrameCapture);
+
+  // Writes whatever is still queued
+  ~FrameCapture();
+
+  // Call between drawing and present(). Returns false if the frame was dropped.
+  bool capture(SDLRenderer &);
+
+  // Waits until every captured frame has been written
+  void flush();
+
+  [[nodiscard]] std::uint64_t frames() const { return next_frame_; }
+
+  [[nodiscard]] std::uint64_t written() const { return written_; }
+
+  [[nodiscard]] std::uint64_t dropped() const { return dropped_; }
+
+  [[nodiscard]] std::uint64_t failed() const { return failed_; }
+
+  // The first write that failed, if any did
+  [[nodiscard]] std::optional<std::string> first_error() const;
+
+private:
+  struct Buffer {
+    std::vector<Uint32> pixels;
+    IntVector size;
+    std::uint64_t frame;
+  };
+
+  SDLImageContext &image_context_;
+  CaptureConfig config_;
+  std::vector<Buffer> buffers_;
+  // Game thread only
+  std::uint64_t next_frame_;
+  std::atomic<std::uint64_t> written_;
+  std::atomic<std::uint64_t> dropped_;
+  std::atomic<std::uint64_t> failed_;
+  mutable std::mutex mutex_;
+  std::condition_variable queued_;
+  std::condition_variable returned_;
+  // Indices into buffers_
+  std::vector<std::size_t> free_;
+  std::deque<std::size_t> pending_;
+  std::optional<std::string> first_error_;
+  bool stop_;
+  std::vector<std::thread> workers_;
+
+  void work();
+
+  void write(Buffer &);
+};
+
+std::string format_capture(FrameCapture const &);
+}
@@ -1,24 +1,9 @@
 #include <algorithm>
 #include <iostream>
+#include <sstream>
 #include "GameState.hpp"
 
 namespace {
-sg::DoubleVector enemy_type_to_speed(sg::EnemyType const &t) {
-  switch (t) {
-    case sg::EnemyType::AsteroidMedium:
-      return sg::asteroid_medium_speed;
-  }
-  throw std::runtime_error("cannot determine speed for enemy type");
-}
-
-sg::Health enemy_type_to_health(sg::EnemyType const &t) {
-  switch (t) {
-    case sg::EnemyType::AsteroidMedium:
-      return sg::asteroid_medium_health;
-  }
-  throw std::runtime_error("cannot determine health for enemy type");
-}
-
 template<typename Container, typename F>
 void erase_if(Container &container, F const &f) {
   container.erase(std::remove_if(container.begin(), container.end(), f), container.end());
@@ -32,40 +17,93 @@ sg::Rectangle<T> projectile_rect(sg::Projectile const &v) {
 
 template<typename T>
 sg::Rectangle<T> asteroid_rect(sg::Asteroid const &v) {
-  return sg::embiggen(sg::Rectangle<T>::from_pos_and_size(sg::structure_cast<T>(v.position),
-                                                          sg::structure_cast<T>(v.size)), 0.75);
+  return sg::Rectangle<T>::from_pos_and_size(sg::structure_cast<T>(v.position), sg::structure_cast<T>(v.size));
+}
+
+sg::IntUpdateDiff const shot_cooldown{500};
+
+// Animations are done once past their duration
+sg::IntUpdateDiff particle_expiry(sg::Particle const &p) {
+  return p.started + sg::explosion_animation.animation->duration + sg::IntUpdateDiff{1};
+}
+
+// Pixel masks are sampled at least this often (in pixels of relative motion)
+// between entering and leaving the other bounding box.
+double const mask_sample_distance{2.0};
+
+// Bounds of a box moving from `previous` to `current`, grown by a pixel so
+// rounding to float never loses a touching contact.
+sg::FloatRectangle swept_bounds(sg::DoubleVector const &previous, sg::DoubleVector const &current,
+                                sg::IntVector const &size) {
+  auto const double_size{sg::structure_cast<double>(size)};
+  auto const bounds{sg::rect_union(sg::Rectangle<double>::from_pos_and_size(previous, double_size),
+                                   sg::Rectangle<double>::from_pos_and_size(current, double_size))};
+  return sg::FloatRectangle{static_cast<float>(bounds.left() - 1.0), static_cast<float>(bounds.right() + 1.0),
+                            static_cast<float>(bounds.top() - 1.0), static_cast<float>(bounds.bottom() + 1.0)};
 }
+
+sg::DoubleVector lerp(sg::DoubleVector const &a, sg::DoubleVector const &b, double const t) {
+  return a + (b - a) * t;
 }
+}
+
+sg::GameState::GameState(RandomEngine &_random_engine, Console &_console, std::size_t const _player_count)
+        : GameState{_random_engine,
+                    _console,
+                    SpawnList{EnemySpawn{sg::EnemyType::AsteroidMedium,
+                                         std::chrono::milliseconds{2000},
+                                         DoubleVector{120, -43},
+                                         1}},
+                    _player_count} {}
 
-sg::GameState::GameState(RandomEngine &_random_engine, Console &_console)
+sg::GameState::GameState(RandomEngine &_random_engine, Console &_console, SpawnList _spawns,
+                         std::size_t const _player_count)
         : random_engine_{_random_engine},
           console_{_console},
-          game_start_{Clock::now()},
-          spawns_{EnemySpawn{sg::EnemyType::AsteroidMedium,
-                             std::chrono::milliseconds{2000},
-                             DoubleVector{120, -43},
-                             1}},
-          player_position_{sg::structure_cast<double>(game_size / 2 - player_size / 2)},
-          player_v_{0, 0},
-          player_shooting_{false},
-          score_{0} {}
-
-void sg::GameState::add_player_v(sg::IntVector const &v) {
-  player_v_ = sg::IntVector{player_v_.x() + v.x(), player_v_.y() + v.y()};
-}
-
-sg::EventList sg::GameState::update(IntUpdateDiff const &diff_secs) {
-  auto const elapsed_time = Clock::now() - game_start_;
-  process_spawns(elapsed_time);
-  auto result = EventList{};
+          elapsed_{0},
+          spawns_{std::move(_spawns)},
+          players_{},
+          particles_{},
+          next_particle_id_{0},
+          timers_{elapsed_},
+          score_{0} {
+  // Players start side by side, evenly spread across the screen
+  for (std::size_t i{0}; i < _player_count; ++i)
+    players_.push_back(Player{DoubleVector{
+            static_cast<double>(game_size.x()) * static_cast<double>(i + 1) / static_cast<double>(_player_count + 1)
+            - static_cast<double>(player_size.x()) / 2.0,
+            static_cast<double>(game_size.y() / 2 - player_size.y() / 2)}});
+  schedule_next_spawn();
+}
+
+void sg::GameState::add_player_v(sg::IntVector const &v, PlayerIndex const player) {
+  IntVector &player_v{players_[player].v};
+  player_v = sg::IntVector{player_v.x() + v.x(), player_v.y() + v.y()};
+}
+
+sg::PlayerInput sg::GameState::player_input(PlayerIndex const player) const {
+  return PlayerInput{players_[player].v, players_[player].shooting};
+}
+
+void sg::GameState::set_player_input(PlayerInput const &input, PlayerIndex const player) {
+  players_[player].v = input.direction;
+  player_shooting(input.shooting, player);
+}
+
+void sg::GameState::update(IntUpdateDiff const &diff_secs, GameEventBus &events) {
+  elapsed_ += diff_secs;
+  timers_.advance(elapsed_, [this](GameTimer const &t) { fire(t); });
   double const secs{std::chrono::duration_cast<DoubleUpdateDiff>(diff_secs).count()};
 
-  // Move player
-  player_position_ += player_speed * (secs * sg::normalize(sg::structure_cast<double>(player_v_)));
+  // Move players
+  for (Player &p : players_)
+    p.position += player_speed * (secs * sg::normalize(sg::structure_cast<double>(p.v)));
 
   // Move projectiles
-  for (ProjectileVector::size_type i{0}; i < projectiles_.size(); ++i)
+  for (ProjectileVector::size_type i{0}; i < projectiles_.size(); ++i) {
+    projectiles_[i].previous_position = projectiles_[i].position;
     projectiles_[i].position += secs * sg::DoubleVector{0, projectile_speed};
+  }
 
   auto const double_game_rect{structure_cast<double>(game_rect)};
   auto const bigger_game_rect(embiggen<double>(double_game_rect, 2));
@@ -75,99 +113,330 @@ sg::EventList sg::GameState::update(IntUpdateDiff const &diff_secs) {
     return !sg::rect_intersect(bigger_game_rect, projectile_rect<double>(v));
   });
 
-  // Move asteroids
-  for (Asteroid &asteroid : asteroids_)
-    asteroid.position += secs * enemy_type_to_speed(asteroid.type);
+  // Move asteroids, one specialized kernel per enemy type
+  for_each_enemy_type([this, secs](auto const type) {
+    move_enemies<decltype(type)::value>(asteroids_[static_cast<std::size_t>(type())], secs);
+  });
 
   // Remove asteroids that are out of screen
-  erase_if(asteroids_, [&bigger_game_rect, this](sg::Asteroid const &v) {
-    bool const result{!sg::rect_intersect(bigger_game_rect, asteroid_rect<double>(v))};
-    if (result)
-      console_.add_line("removing asteroid", true);
-    return result;
-  });
+  for (AsteroidVector &bucket : asteroids_)
+    erase_if(bucket, [&bigger_game_rect, this](sg::Asteroid const &v) {
+      bool const result{!sg::rect_intersect(bigger_game_rect, asteroid_rect<double>(v))};
+      if (result)
+        console_.add_line("removing asteroid", true);
+      return result;
+    });
 
-  // Handle asteroid projectile collisions
+  // Handle asteroid projectile collisions; swept over the whole tick, the
+  // earliest impact wins. Each projectile is tested against the bounds of
+  // all enemy sweeps at once to find the candidates.
+  enemy_bounds_.clear();
+  enemy_slots_.clear();
+  for (std::size_t type{0}; type < asteroids_.size(); ++type)
+    for (std::size_t i{0}; i < asteroids_[type].size(); ++i) {
+      Asteroid const &a{asteroids_[type][i]};
+      enemy_bounds_.push(swept_bounds(a.previous_position, a.position, a.size));
+      enemy_slots_.emplace_back(type, i);
+    }
+  destroyed_.assign(enemy_slots_.size(), false);
+  candidates_.resize(enemy_slots_.size());
   for (ProjectileVector::iterator pit{this->projectiles_.begin()}; pit != this->projectiles_.end();) {
-    auto const prect{projectile_rect<double>(*pit)};
-    bool found{false};
-    for (AsteroidVector::iterator ait{this->asteroids_.begin()}; ait != this->asteroids_.end(); ++ait) {
-      if (rect_intersect(prect, asteroid_rect<double>(*ait))) {
-        found = true;
-        ait->health -= projectile_damage;
-        if (ait->health <= 0) {
-          score_ += ait->score;
-          result.push_back(GameEvent::AsteroidDestroyed);
-          particles_.push_back(Particle{DoubleVector{0, 0}, Animation{explosion_animation, ait->position}});
-          this->asteroids_.erase(ait);
-        }
-        break;
+    auto const bounds{swept_bounds(pit->previous_position, pit->position, projectile_size)};
+    auto const candidate_count{intersecting(bounds, enemy_bounds_, candidates_.data())};
+    std::optional<double> earliest;
+    std::optional<std::uint32_t> hit;
+    for (std::size_t ci{0}; ci < candidate_count; ++ci) {
+      std::uint32_t const c{candidates_[ci]};
+      if (destroyed_[c])
+        continue;
+      auto const t{time_of_impact(*pit, asteroids_[enemy_slots_[c].first][enemy_slots_[c].second])};
+      if (t.has_value() && (!earliest.has_value() || t.value() < earliest.value())) {
+        earliest = t;
+        hit = c;
       }
     }
-    if (found)
-      pit = this->projectiles_.erase(pit);
-    else
+    if (!hit.has_value()) {
       ++pit;
+      continue;
+    }
+    Asteroid &a{asteroids_[enemy_slots_[hit.value()].first][enemy_slots_[hit.value()].second]};
+    a.health -= projectile_damage;
+    if (a.health <= 0) {
+      score_ += a.score;
+      DoubleVector const impact{lerp(a.previous_position, a.position, earliest.value())};
+      events.publish(AsteroidDestroyed{a.type, impact + structure_cast<double>(a.size) / 2.0, a.score});
+      // Explosions start with the tick, like everything else that happens in it
+      particles_.push_back(Particle{next_particle_id_++, DoubleVector{0, 0}, impact, elapsed_ - diff_secs});
+      timers_.schedule(particle_expiry(particles_.back()),
+                       GameTimer{GameTimerKind::ParticleExpired, particles_.back().id});
+      destroyed_[hit.value()] = true;
+    }
+    pit = this->projectiles_.erase(pit);
+  }
+  // Remove destroyed asteroids, keeping the order of the rest
+  std::size_t slot{0};
+  for (AsteroidVector &bucket : asteroids_) {
+    std::size_t kept{0};
+    for (std::size_t i{0}; i < bucket.size(); ++i, ++slot)
+      if (!destroyed_[slot])
+        bucket[kept++] = bucket[i];
+    bucket.erase(bucket.begin() + static_cast<std::ptrdiff_t>(kept), bucket.end());
   }
 
   // Add projectiles
-  auto const now = Clock::now();
-  if (player_shooting_) {
-    if (!last_shot_.has_value() || (now - last_shot_.value()) > std::chrono::milliseconds{500}) {
-      result.push_back(sg::GameEvent::PlayerShot);
-      projectiles_.push_back(Projectile{
-              player_position_ + sg::DoubleVector{static_cast<double>(player_size.x()) / 2.0, 0},
-              ProjectileType::StandardLaser});
-      last_shot_ = now;
+  for (PlayerIndex i{0}; i < players_.size(); ++i) {
+    Player &p{players_[i]};
+    if (p.shooting && !p.reloading) {
+      DoubleVector const muzzle{p.position + sg::DoubleVector{static_cast<double>(player_size.x()) / 2.0, 0}};
+      events.publish(PlayerShot{i, muzzle});
+      projectiles_.push_back(Projectile{muzzle, ProjectileType::StandardLaser});
+      p.last_shot = elapsed_;
+      schedule_reload(i);
     }
   }
+}
 
-  // Handle particles
-  // Update/move particles
-  for (Particle &p : particles_) {
-    p.animation.move(p.velocity * secs);
-    p.animation.update(diff_secs);
+void sg::GameState::fire(GameTimer const &t) {
+  switch (t.kind) {
+    case GameTimerKind::ShotReady:
+      players_[t.target].reloading = false;
+      break;
+    case GameTimerKind::ParticleExpired: {
+      auto const it{std::lower_bound(particles_.begin(), particles_.end(), t.target,
+                                     [](Particle const &p, ParticleId const id) { return p.id < id; })};
+      if (it != particles_.end() && it->id == t.target)
+        particles_.erase(it);
+      break;
+    }
+    case GameTimerKind::SpawnDue:
+      process_spawns(elapsed_);
+      schedule_next_spawn();
+      break;
+  }
+}
+
+void sg::GameState::schedule_next_spawn() {
+  // The list is sorted by time, so only its head needs a timer
+  if (!spawns_.empty())
+    timers_.schedule(spawns_.front().spawn_after, GameTimer{GameTimerKind::SpawnDue, 0});
+}
 
+void sg::GameState::schedule_reload(PlayerIndex const player) {
+  Player &p{players_[player]};
+  // Shooting again takes strictly more than the cooldown
+  IntUpdateDiff const ready{p.last_shot.value() + shot_cooldown + IntUpdateDiff{1}};
+  p.reloading = ready > elapsed_;
+  if (p.reloading)
+    p.reload_timer = timers_.schedule(ready, GameTimer{GameTimerKind::ShotReady, static_cast<std::uint32_t>(player)});
+}
+
+void sg::GameState::process_spawns(IntUpdateDiff const &elapsed_time) {
+  for (sg::SpawnList::iterator it{spawns_.begin()}; it != spawns_.end() && it->spawn_after <= elapsed_time;) {
+    EnemyInfo const &info{enemy_info(it->type)};
+    console_.add_line("spawning asteroid", true);
+    asteroids_[static_cast<std::size_t>(it->type)].push_back(
+            sg::Asteroid{it->spawn_position, sg::IntVector{info.width, info.height}, it->type, info.health, it->score});
+    it = spawns_.erase(it);
   }
-  // Remove stale particles
-  erase_if(particles_, [](sg::Particle const &v) { return v.animation.done(); });
+}
 
+std::size_t sg::GameState::enemy_count() const {
+  std::size_t result{0};
+  for (AsteroidVector const &bucket : asteroids_)
+    result += bucket.size();
   return result;
 }
 
-void sg::GameState::process_spawns(Clock::time_point::duration const &elapsed_time) {
-  for (sg::SpawnList::iterator it{spawns_.begin()}; it != spawns_.end(); ++it) {
-    if (it->spawn_after > elapsed_time)
-      break;
-    if (it->type == sg::EnemyType::AsteroidMedium) {
-      auto size = sg::IntVector{42, 42};
-      console_.add_line("spawning asteroid", true);
-      asteroids_.push_back(sg::Asteroid{it->spawn_position, size, it->type, enemy_type_to_health(it->type), it->score});
-    }
-    it = spawns_.erase(it);
+void sg::GameState::load_collision_masks(Atlas const &atlas) {
+  CollisionMask const *const laser{atlas.mask(laser_path)};
+  if (laser != nullptr)
+    projectile_mask_ = laser->scaled(projectile_size);
+  for (std::size_t type{0}; type < enemy_type_count; ++type) {
+    EnemyInfo const &info{enemy_info(static_cast<EnemyType>(type))};
+    CollisionMask const *const enemy{atlas.mask(enemy_texture(static_cast<EnemyType>(type)))};
+    if (enemy != nullptr)
+      enemy_masks_[type] = enemy->scaled(IntVector{info.width, info.height});
+  }
+}
+
+std::optional<double> sg::GameState::time_of_impact(Projectile const &p, Asteroid const &a) const {
+  auto const relative_motion{(p.position - p.previous_position) - (a.position - a.previous_position)};
+  auto const swept{swept_intersect(
+          Rectangle<double>::from_pos_and_size(p.previous_position, structure_cast<double>(projectile_size)),
+          relative_motion,
+          Rectangle<double>::from_pos_and_size(a.previous_position, structure_cast<double>(a.size)))};
+  if (!swept.has_value())
+    return std::nullopt;
+  auto const &enemy_mask{enemy_masks_[static_cast<std::size_t>(a.type)]};
+  if (!projectile_mask_.has_value() || !enemy_mask.has_value())
+    return swept->first;
+  auto const [enter, exit] = swept.value();
+  auto const steps{std::max(1, static_cast<int>(std::ceil(length(relative_motion) * (exit - enter) / mask_sample_distance)))};
+  for (int i{0}; i <= steps; ++i) {
+    double const t{enter + (exit - enter) * i / steps};
+    if (masks_overlap(projectile_mask_.value(),
+                      rounding_cast<int>(lerp(p.previous_position, p.position, t)),
+                      enemy_mask.value(),
+                      rounding_cast<int>(lerp(a.previous_position, a.position, t))))
+      return t;
   }
+  return std::nullopt;
 }
 
-void sg::GameState::player_shooting(bool const b) {
-  if (b == player_shooting_)
+void sg::GameState::player_shooting(bool const b, PlayerIndex const player) {
+  Player &p{players_[player]};
+  if (b == p.shooting)
     return;
-  player_shooting_ = b;
-  if (!b)
-    last_shot_ = std::nullopt;
+  p.shooting = b;
+  if (!b) {
+    p.last_shot = std::nullopt;
+    p.reloading = false;
+    timers_.cancel(p.reload_timer);
+  }
 }
 
 sg::RenderObjectList sg::GameState::draw() {
-  sg::RenderObjectList result{sg::Image(player_rect(), main_atlas_path, ship_path)};
+  sg::RenderObjectList result;
+  for (PlayerIndex i{0}; i < players_.size(); ++i)
+    result.push_back(Image{player_rect(i), main_atlas_path, i == 0 ? ship_path : second_ship_path});
   for (sg::GameState::ProjectileVector::value_type const &p : projectiles_)
     result.push_back(Image{sg::IntRectangle::from_pos_and_size(sg::rounding_cast<int>(p.position), projectile_size),
                            main_atlas_path,
                            laser_path});
-  for (sg::GameState::AsteroidVector::value_type const &p : asteroids_)
-    result.push_back(Image{sg::IntRectangle::from_pos_and_size(sg::rounding_cast<int>(p.position), p.size),
-                           main_atlas_path,
-                           asteroid_medium_path});
-  for (sg::GameState::ParticleVector ::value_type const &p : particles_)
-    append(result, p.animation.render());
-  result.push_back(sg::Text{score_font, "Score: " + std::to_string(score_), IntVector{0, 0}, score_color});
+  for (std::size_t type{0}; type < asteroids_.size(); ++type) {
+    auto const texture{enemy_texture(static_cast<EnemyType>(type))};
+    for (sg::GameState::AsteroidVector::value_type const &p : asteroids_[type])
+      result.push_back(Image{sg::IntRectangle::from_pos_and_size(sg::rounding_cast<int>(p.position), p.size),
+                             main_atlas_path,
+                             texture});
+  }
+  return result;
+}
+
+sg::RenderObjectList sg::GameState::draw_effects(std::size_t const max_particles) const {
+  sg::RenderObjectList result;
+  auto const first{particles_.size() - std::min(particles_.size(), max_particles)};
+  for (auto it{particles_.begin() + static_cast<std::ptrdiff_t>(first)}; it != particles_.end(); ++it)
+    append(result, particle_animation(*it).render());
+  return result;
+}
+
+sg::Animation sg::GameState::particle_animation(Particle const &p) const {
+  IntUpdateDiff const age{elapsed_ - p.started};
+  double const secs{std::chrono::duration_cast<DoubleUpdateDiff>(age).count()};
+  return Animation{explosion_animation, p.origin + p.velocity * secs, age};
+}
+
+sg::RenderObjectList sg::GameState::draw_hud() const {
+  return {sg::Text{score_font, "Score: " + std::to_string(score_), IntVector{0, 0}, score_color}};
+}
+
+sg::Snapshot sg::GameState::snapshot() const {
+  Snapshot result;
+  SnapshotWriter w{result};
+  std::ostringstream random_state;
+  random_state << random_engine_;
+  w.put_string(random_state.str());
+  w.put(elapsed_.count());
+  w.put(static_cast<std::uint32_t>(players_.size()));
+  for (Player const &p : players_) {
+    w.put(p.position);
+    w.put(p.v);
+    w.put(p.shooting);
+    w.put(p.last_shot.has_value());
+    w.put(p.last_shot.value_or(IntUpdateDiff{0}).count());
+  }
+  w.put(score_);
+  w.put(static_cast<std::uint32_t>(spawns_.size()));
+  for (EnemySpawn const &s : spawns_) {
+    w.put(s.type);
+    w.put(s.spawn_after.count());
+    w.put(s.spawn_position);
+    w.put(s.score);
+  }
+  w.put(static_cast<std::uint32_t>(projectiles_.size()));
+  for (Projectile const &p : projectiles_) {
+    w.put(p.position);
+    w.put(p.previous_position);
+    w.put(p.type);
+  }
+  for (AsteroidVector const &bucket : asteroids_) {
+    w.put(static_cast<std::uint32_t>(bucket.size()));
+    for (Asteroid const &a : bucket) {
+      w.put(a.position);
+      w.put(a.previous_position);
+      w.put(a.health);
+      w.put(a.score);
+    }
+  }
+  w.put(next_particle_id_);
+  w.put(static_cast<std::uint32_t>(particles_.size()));
+  for (Particle const &p : particles_) {
+    w.put(p.id);
+    w.put(p.velocity);
+    w.put(p.origin);
+    w.put(p.started.count());
+  }
   return result;
 }
+
+void sg::GameState::restore(Snapshot const &snapshot) {
+  SnapshotReader r{snapshot};
+  std::istringstream random_state{r.get_string()};
+  random_state >> random_engine_;
+  elapsed_ = IntUpdateDiff{r.get<IntUpdateDiff::rep>()};
+  players_.clear();
+  for (auto n{r.get<std::uint32_t>()}; n > 0; --n) {
+    Player p{r.get<DoubleVector>()};
+    p.v = r.get<IntVector>();
+    p.shooting = r.get<bool>();
+    bool const has_last_shot{r.get<bool>()};
+    IntUpdateDiff const last_shot{r.get<IntUpdateDiff::rep>()};
+    p.last_shot = has_last_shot ? std::optional{last_shot} : std::nullopt;
+    players_.push_back(p);
+  }
+  score_ = r.get<Score>();
+  spawns_.clear();
+  for (auto n{r.get<std::uint32_t>()}; n > 0; --n) {
+    auto const type{r.get<EnemyType>()};
+    auto const spawn_after{r.get<std::chrono::milliseconds::rep>()};
+    auto const spawn_position{r.get<DoubleVector>()};
+    spawns_.push_back(EnemySpawn{type, std::chrono::milliseconds{spawn_after}, spawn_position, r.get<Score>()});
+  }
+  projectiles_.clear();
+  for (auto n{r.get<std::uint32_t>()}; n > 0; --n) {
+    Projectile p{r.get<DoubleVector>(), ProjectileType::StandardLaser};
+    p.previous_position = r.get<DoubleVector>();
+    p.type = r.get<ProjectileType>();
+    projectiles_.push_back(p);
+  }
+  for (std::size_t type{0}; type < asteroids_.size(); ++type) {
+    EnemyInfo const &info{enemy_info(static_cast<EnemyType>(type))};
+    asteroids_[type].clear();
+    for (auto n{r.get<std::uint32_t>()}; n > 0; --n) {
+      auto const position{r.get<DoubleVector>()};
+      auto const previous_position{r.get<DoubleVector>()};
+      auto const health{r.get<Health>()};
+      Asteroid a{position, IntVector{info.width, info.height}, static_cast<EnemyType>(type), health, r.get<Score>()};
+      a.previous_position = previous_position;
+      asteroids_[type].push_back(a);
+    }
+  }
+  next_particle_id_ = r.get<ParticleId>();
+  particles_.clear();
+  for (auto n{r.get<std::uint32_t>()}; n > 0; --n) {
+    auto const id{r.get<ParticleId>()};
+    auto const velocity{r.get<DoubleVector>()};
+    auto const origin{r.get<DoubleVector>()};
+    particles_.push_back(Particle{id, velocity, origin, IntUpdateDiff{r.get<IntUpdateDiff::rep>()}});
+  }
+
+  // Everything due by now has fired, so what's left is in the future.
+  timers_.clear(elapsed_);
+  schedule_next_spawn();
+  for (PlayerIndex i{0}; i < players_.size(); ++i)
+    if (players_[i].last_shot.has_value())
+      schedule_reload(i);
+  for (Particle const &p : particles_)
+    timers_.schedule(particle_expiry(p), GameTimer{GameTimerKind::ParticleExpired, p.id});
+}
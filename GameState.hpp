@@ -7,17 +7,18 @@
 #include "RenderObject.hpp"
 #include "Console.hpp"
 #include "Animation.hpp"
+#include "Enemies.hpp"
+#include "memory_tracking.hpp"
+#include "Snapshot.hpp"
+#include "batch_math.hpp"
+#include "EventBus.hpp"
+#include "TimerWheel.hpp"
+#include <deque>
 #include <utility>
 #include <vector>
 #include <list>
 
 namespace sg {
-enum class GameEvent {
-  PlayerShot, AsteroidDestroyed
-};
-enum class EnemyType {
-  AsteroidMedium
-};
 enum class ProjectileType {
   StandardLaser
 };
@@ -30,71 +31,190 @@ struct EnemySpawn {
 
 struct Asteroid {
   DoubleVector position;
+  DoubleVector previous_position;
   IntVector size;
   EnemyType type;
   Health health;
   Score score;
 
   Asteroid(const sg::DoubleVector &position, const sg::IntVector &size, EnemyType const &type, Health const health, Score const score)
-          : position{position}, size{size}, type{type}, health{health}, score{score} {}
+          : position{position}, previous_position{position}, size{size}, type{type}, health{health}, score{score} {}
 };
 
+using ParticleId = std::uint32_t;
+
+// An explosion; where it is and how far along follows from when it started.
 struct Particle {
+  ParticleId id;
   DoubleVector velocity;
-  Animation animation;
+  DoubleVector origin;
+  IntUpdateDiff started;
 
-  Particle(const DoubleVector &velocity, Animation animation) : velocity(velocity), animation(std::move(animation)) {}
+  Particle(ParticleId const id, const DoubleVector &velocity, const DoubleVector &origin, IntUpdateDiff const started)
+          : id(id), velocity(velocity), origin(origin), started(started) {}
 };
 
 struct Projectile {
   DoubleVector position;
+  DoubleVector previous_position;
   ProjectileType type;
 
   Projectile(const sg::DoubleVector &position, sg::ProjectileType type)
-          : position(position), type(type) {}
+          : position(position), previous_position(position), type(type) {}
 };
 
-using EventList = std::vector<sg::GameEvent>;
+struct Player {
+  DoubleVector position;
+  IntVector v;
+  bool shooting;
+  std::optional<IntUpdateDiff> last_shot;
+  // Until the reload timer fires
+  bool reloading;
+  TimerHandle reload_timer;
+
+  explicit Player(DoubleVector const &position)
+          : position{position}, v{0, 0}, shooting{false}, last_shot{}, reloading{false}, reload_timer{} {}
+};
 
-using SpawnList = std::list<sg::EnemySpawn>;
+// Held-down input state of one player for one tick
+struct PlayerInput {
+  IntVector direction;
+  bool shooting;
+
+  bool operator==(PlayerInput const &o) const {
+    return direction.x() == o.direction.x() && direction.y() == o.direction.y() && shooting == o.shooting;
+  }
+
+  bool operator!=(PlayerInput const &o) const { return !(*this == o); }
+};
+
+using PlayerIndex = std::size_t;
+
+struct PlayerShot {
+  PlayerIndex player;
+  // Where the projectile starts
+  DoubleVector position;
+};
+
+struct AsteroidDestroyed {
+  EnemyType type;
+  // Center at the moment of impact
+  DoubleVector position;
+  Score score_delta;
+};
+
+using GameEventBus = EventBus<PlayerShot, AsteroidDestroyed>;
+
+enum class GameTimerKind : std::uint8_t {
+  // `target` is the player
+  ShotReady,
+  // `target` is the particle id
+  ParticleExpired,
+  // The first of the spawn list is due
+  SpawnDue
+};
+
+struct GameTimer {
+  GameTimerKind kind;
+  std::uint32_t target;
+};
+
+using SpawnList = std::list<sg::EnemySpawn, TaggedAllocator<sg::EnemySpawn, MemoryTag::GameState>>;
 
 class GameState {
 public:
-  using ProjectileVector = std::vector<Projectile>;
-  using AsteroidVector = std::vector<Asteroid>;
-  using ParticleVector = std::vector<Particle>;
+  using ProjectileVector = TaggedVector<Projectile, MemoryTag::GameState>;
+  using AsteroidVector = TaggedVector<Asteroid, MemoryTag::GameState>;
+  // One vector per enemy type, indexed by EnemyType
+  using AsteroidBuckets = std::array<AsteroidVector, enemy_type_count>;
+  // Particles all live equally long, so they expire from the front.
+  using ParticleDeque = std::deque<Particle, TaggedAllocator<Particle, MemoryTag::GameState>>;
+
+  GameState(RandomEngine &, Console &, std::size_t player_count = 1);
 
-  GameState(RandomEngine &, Console &);
+  GameState(RandomEngine &, Console &, SpawnList, std::size_t player_count = 1);
 
-  [[nodiscard]] IntRectangle player_rect() const {
+  [[nodiscard]] IntRectangle player_rect(PlayerIndex const player = 0) const {
     return sg::IntRectangle::from_pos_and_size(
-            rounding_cast<int>(player_position_), player_size);
+            rounding_cast<int>(players_[player].position), player_size);
   }
 
-  void add_player_v(IntVector const &);
+  [[nodiscard]] std::size_t player_count() const { return players_.size(); }
+
+  void add_player_v(IntVector const &, PlayerIndex = 0);
+
+  [[nodiscard]] PlayerInput player_input(PlayerIndex = 0) const;
 
-  EventList update(IntUpdateDiff const &);
+  void set_player_input(PlayerInput const &, PlayerIndex = 0);
 
-  void player_shooting(bool b);
+  // Publishes what happened during the tick; dispatching is up to the caller.
+  void update(IntUpdateDiff const &, GameEventBus &);
+
+  void player_shooting(bool b, PlayerIndex = 0);
+
+  // Enables pixel-accurate collisions; without masks, bounding boxes decide.
+  void load_collision_masks(Atlas const &);
 
   RenderObjectList draw();
 
+  [[nodiscard]] std::size_t enemy_count() const;
+
+  [[nodiscard]] std::size_t projectile_count() const { return projectiles_.size(); }
+
+  [[nodiscard]] std::size_t particle_count() const { return particles_.size(); }
+
+  // Draws at most max_particles of the newest particles; the rest still
+  // simulate, so lockstep peers and snapshots don't depend on quality.
+  [[nodiscard]] RenderObjectList draw_effects(
+          std::size_t max_particles = std::numeric_limits<std::size_t>::max()) const;
+
+  [[nodiscard]] RenderObjectList draw_hud() const;
+
+  [[nodiscard]] Score score() const { return score_; }
+
+  // Everything that evolves during play, including the random engine state;
+  // restoring it resumes the game exactly where the snapshot was taken.
+  [[nodiscard]] Snapshot snapshot() const;
+
+  // Player input comes back as it was when the snapshot was taken; re-apply
+  // the live input unless the snapshot is replayed with its own.
+  void restore(Snapshot const &);
+
 private:
   RandomEngine &random_engine_;
   Console &console_;
-  Clock::time_point game_start_;
+  IntUpdateDiff elapsed_;
   SpawnList spawns_;
-  DoubleVector player_position_;
-  IntVector player_v_;
-  bool player_shooting_;
-  std::optional<TimePoint> last_shot_;
+  TaggedVector<Player, MemoryTag::GameState> players_;
   ProjectileVector projectiles_;
-  AsteroidVector asteroids_;
-  ParticleVector particles_;
+  AsteroidBuckets asteroids_;
+  // Ordered by id
+  ParticleDeque particles_;
+  ParticleId next_particle_id_;
+  // Shot cooldowns, particle lifetimes and spawns, in terms of elapsed_. Not
+  // part of snapshots; restore() reschedules from the rest of the state.
+  TimerWheel<GameTimer> timers_;
   Score score_;
+  std::optional<CollisionMask> projectile_mask_;
+  std::array<std::optional<CollisionMask>, enemy_type_count> enemy_masks_;
+  // Collision scratch space, kept to avoid allocating every tick
+  AabbBatch<TaggedAllocator<float, MemoryTag::GameState>> enemy_bounds_;
+  TaggedVector<std::pair<std::size_t, std::size_t>, MemoryTag::GameState> enemy_slots_;
+  TaggedVector<bool, MemoryTag::GameState> destroyed_;
+  TaggedVector<std::uint32_t, MemoryTag::GameState> candidates_;
+
+  // Fraction of the last tick at which the projectile hit the asteroid
+  [[nodiscard]] std::optional<double> time_of_impact(Projectile const &, Asteroid const &) const;
+
+  void fire(GameTimer const &);
+
+  void process_spawns(IntUpdateDiff const &);
+
+  void schedule_next_spawn();
+
+  void schedule_reload(PlayerIndex);
 
-  void process_spawns(
-          Clock::time_point::duration const &);
+  [[nodiscard]] Animation particle_animation(Particle const &) const;
 };
 }
 
@@ -0,0 +1,115 @@
+#include "InputLatency.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace {
+// Boundaries of the histogram rows shown, in ms
+std::array<Uint32, 8> const report_buckets{0, 8, 17, 33, 50, 100, 250, sg::InputLatency::max_ms + 1};
+std::size_t const bar_width{24};
+
+struct SyntheticKey {
+  SDL_Keycode key;
+  bool down;
+};
+
+// Moves back and forth while firing now and then
+std::array<SyntheticKey, 8> const synthetic_keys{{
+        {SDLK_a, true}, {SDLK_a, false}, {SDLK_SPACE, true}, {SDLK_SPACE, false},
+        {SDLK_d, true}, {SDLK_d, false}, {SDLK_w, true}, {SDLK_w, false},
+}};
+}
+
+sg::InputLatency::InputLatency()
+        : pending_{}, next_tick_{0}, histogram_{}, samples_{0}, total_ms_{0}, max_{0} {}
+
+void sg::InputLatency::input(Uint32 const timestamp, TickId const applied_by) {
+  pending_.push_back(Pending{timestamp, applied_by});
+}
+
+void sg::InputLatency::simulated(TickId const next) {
+  next_tick_ = next;
+}
+
+void sg::InputLatency::presented(Uint32 const now) {
+  auto const shown = [this](Pending const &p) { return p.applied_by < next_tick_; };
+  for (Pending const &p : pending_) {
+    if (!shown(p))
+      continue;
+    // Unsigned, so this survives the tick counter wrapping
+    Uint32 const latency{now - p.timestamp};
+    histogram_[std::min<std::size_t>(latency, max_ms)]++;
+    samples_++;
+    total_ms_ += latency;
+    max_ = std::max(max_, latency);
+  }
+  pending_.erase(std::remove_if(pending_.begin(), pending_.end(), shown), pending_.end());
+}
+
+double sg::InputLatency::mean_ms() const {
+  return samples_ == 0 ? 0.0 : static_cast<double>(total_ms_) / static_cast<double>(samples_);
+}
+
+Uint32 sg::InputLatency::percentile_ms(double const fraction) const {
+  auto const wanted{static_cast<std::uint64_t>(fraction * static_cast<double>(samples_))};
+  std::uint64_t seen{0};
+  for (std::size_t ms{0}; ms < histogram_.size(); ++ms) {
+    seen += histogram_[ms];
+    if (seen > 0 && seen >= wanted)
+      return static_cast<Uint32>(ms);
+  }
+  return 0;
+}
+
+std::uint64_t sg::InputLatency::count(Uint32 const from, Uint32 const to) const {
+  std::uint64_t result{0};
+  for (std::size_t ms{from}; ms < std::min<std::size_t>(to, histogram_.size()); ++ms)
+    result += histogram_[ms];
+  return result;
+}
+
+std::vector<std::string> sg::format_input_latency(InputLatency const &latency) {
+  std::vector<std::string> result;
+  std::ostringstream summary;
+  summary.precision(1);
+  summary << std::fixed << "input latency: " << latency.samples() << " inputs, mean " << latency.mean_ms()
+          << " ms, p50 " << latency.percentile_ms(0.5) << " ms, p95 " << latency.percentile_ms(0.95)
+          << " ms, p99 " << latency.percentile_ms(0.99) << " ms, max " << latency.max_latency_ms() << " ms";
+  result.push_back(summary.str());
+  if (latency.samples() == 0)
+    return result;
+  for (std::size_t i{0}; i + 1 < report_buckets.size(); ++i) {
+    auto const n{latency.count(report_buckets[i], report_buckets[i + 1])};
+    std::ostringstream row;
+    row << "  " << report_buckets[i];
+    if (i + 2 < report_buckets.size())
+      row << "-" << report_buckets[i + 1] - 1;
+    else
+      row << "+";
+    row << " ms: " << std::string(n * bar_width / latency.samples(), '#') << " " << n;
+    result.push_back(row.str());
+  }
+  return result;
+}
+
+sg::SyntheticInput::SyntheticInput(SDLContext &_context, std::chrono::milliseconds const _interval)
+        : context_{_context},
+          interval_{static_cast<Uint32>(_interval.count())},
+          next_{SDL_GetTicks() + static_cast<Uint32>(_interval.count())},
+          step_{0} {}
+
+void sg::SyntheticInput::update() {
+  Uint32 const now{SDL_GetTicks()};
+  while (SDL_TICKS_PASSED(now, next_)) {
+    SyntheticKey const &k{synthetic_keys[step_ % synthetic_keys.size()]};
+    SDL_Event e{};
+    e.type = k.down ? SDL_KEYDOWN : SDL_KEYUP;
+    e.key.state = k.down ? SDL_PRESSED : SDL_RELEASED;
+    e.key.repeat = 0;
+    e.key.keysym.sym = k.key;
+    // Stamped with the current time by SDL
+    context_.push_event(e);
+    step_++;
+    next_ += interval_;
+  }
+}
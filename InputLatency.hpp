@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include "SDL.hpp"
+
+namespace sg {
+// Time from an input event, by its SDL timestamp, to the present() of the
+// first frame drawn after the game tick that applied it. SDL timestamps
+// are in milliseconds, so that's the resolution.
+class InputLatency {
+public:
+  using TickId = std::uint64_t;
+  // Anything slower lands in the last bucket
+  static constexpr std::size_t max_ms{500};
+
+  InputLatency();
+
+  // `applied_by` is the first game tick that sees the input.
+  void input(Uint32 timestamp, TickId applied_by);
+
+  // Every tick before `next` has been simulated.
+  void simulated(TickId next);
+
+  // The frame presented at `now` shows everything simulated so far.
+  void presented(Uint32 now);
+
+  [[nodiscard]] std::uint64_t samples() const { return samples_; }
+
+  [[nodiscard]] double mean_ms() const;
+
+  [[nodiscard]] Uint32 max_latency_ms() const { return max_; }
+
+  // Smallest latency at least `fraction` of the samples don't exceed
+  [[nodiscard]] Uint32 percentile_ms(double fraction) const;
+
+  // Samples of [from, to) ms
+  [[nodiscard]] std::uint64_t count(Uint32 from, Uint32 to) const;
+
+private:
+  struct Pending {
+    Uint32 timestamp;
+    TickId applied_by;
+  };
+
+  std::vector<Pending> pending_;
+  TickId next_tick_;
+  std::array<std::uint64_t, max_ms + 1> histogram_;
+  std::uint64_t samples_;
+  std::uint64_t total_ms_;
+  Uint32 max_;
+};
+
+std::vector<std::string> format_input_latency(InputLatency const &);
+
+// Presses and releases the game's keys on a fixed schedule through SDL's
+// event queue, so latency can be measured with nobody at the keyboard.
+class SyntheticInput {
+public:
+  SyntheticInput(SDLContext &, std::chrono::milliseconds interval);
+
+  // Queues the key events that are due.
+  void update();
+
+private:
+  SDLContext &context_;
+  Uint32 interval_;
+  Uint32 next_;
+  std::size_t step_;
+};
+}
@@ -0,0 +1,161 @@
+#include "Lockstep.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+namespace {
+std::uint32_t const packet_magic{0x534c4753}; // "SGLS"
+
+sg::PlayerInput const neutral_input{sg::IntVector{0, 0}, false};
+
+// Two bits per axis plus the fire button
+std::uint8_t pack_input(sg::PlayerInput const &input) {
+  auto const axis = [](int const v) { return static_cast<unsigned>(std::clamp(v, -1, 1) + 1); };
+  return static_cast<std::uint8_t>(axis(input.direction.x()) | axis(input.direction.y()) << 2
+                                   | static_cast<unsigned>(input.shooting) << 4);
+}
+
+sg::PlayerInput unpack_input(std::uint8_t const b) {
+  return sg::PlayerInput{sg::IntVector{(b & 0x3) - 1, (b >> 2 & 0x3) - 1}, (b & 0x10) != 0};
+}
+
+template<std::size_t... I>
+std::array<sg::PlayerInput, sizeof...(I)> neutral_inputs(std::index_sequence<I...>) {
+  return {((void) I, neutral_input)...};
+}
+
+double average_ms(sg::Clock::duration const &total, std::size_t const count) {
+  return count == 0 ? 0.0 : std::chrono::duration<double, std::milli>(total).count() / static_cast<double>(count);
+}
+}
+
+sg::LockstepSession::LockstepSession(UdpSocket _socket, PlayerIndex const _local_player, Tick const _input_delay)
+        : socket_{std::move(_socket)},
+          local_player_{_local_player},
+          input_delay_{_input_delay},
+          tick_{0},
+          local_known_{_input_delay},
+          remote_confirmed_{_input_delay},
+          peer_ack_{_input_delay},
+          local_inputs_{neutral_inputs(std::make_index_sequence<window>{})},
+          remote_inputs_{local_inputs_},
+          predicted_{local_inputs_},
+          sent_at_{},
+          history_{lockstep_max_prediction + 1},
+          replayed_events_{},
+          stats_{} {
+  if (input_delay_ + 2 * lockstep_max_prediction >= window)
+    throw std::runtime_error{"input delay is too long"};
+}
+
+bool sg::LockstepSession::advance(GameState &gs, PlayerInput const &local, GameEventBus &events) {
+  auto const rollback{receive()};
+  if (rollback.has_value()) {
+    ++stats_.rollbacks;
+    gs.restore(history_.rewind(tick_ - 1 - rollback.value()));
+    for (Tick t{rollback.value()}; t < tick_; ++t) {
+      if (t != rollback.value())
+        history_.push(gs.snapshot());
+      simulate(gs, t, replayed_events_);
+      ++stats_.resimulated_ticks;
+    }
+    replayed_events_.discard();
+  }
+  if (tick_ >= remote_confirmed_ + lockstep_max_prediction) {
+    send();
+    ++stats_.stalls;
+    return false;
+  }
+  local_inputs_[local_known_ % window] = local;
+  sent_at_[local_known_ % window] = Clock::now();
+  ++local_known_;
+  send();
+  history_.push(gs.snapshot());
+  simulate(gs, tick_, events);
+  ++tick_;
+  ++stats_.ticks;
+  return true;
+}
+
+sg::IntUpdateDiff sg::LockstepSession::input_delay() const {
+  return lockstep_tick * input_delay_;
+}
+
+std::optional<sg::Tick> sg::LockstepSession::receive() {
+  std::optional<Tick> mispredicted;
+  while (auto const datagram{socket_.receive()}) {
+    stats_.bytes_received += datagram->size();
+    try {
+      SnapshotReader r{datagram.value()};
+      if (r.get<std::uint32_t>() != packet_magic)
+        continue;
+      auto const first{r.get<Tick>()};
+      auto const ack{r.get<Tick>()};
+      auto const count{r.get<std::uint8_t>()};
+      if (ack > peer_ack_ && ack <= local_known_) {
+        if (local_known_ - ack < window) {
+          stats_.round_trip_total += Clock::now() - sent_at_[(ack - 1) % window];
+          ++stats_.round_trips;
+        }
+        peer_ack_ = ack;
+      }
+      for (Tick t{first}; t < first + count; ++t) {
+        auto const input{unpack_input(r.get<std::uint8_t>())};
+        if (t != remote_confirmed_)
+          continue;
+        remote_inputs_[t % window] = input;
+        if (t < tick_ && input != predicted_[t % window] && !mispredicted.has_value())
+          mispredicted = t;
+        ++remote_confirmed_;
+      }
+    } catch (std::runtime_error const &) {
+      // Truncated datagrams are dropped like lost ones
+    }
+  }
+  return mispredicted;
+}
+
+void sg::LockstepSession::send() {
+  Snapshot packet;
+  SnapshotWriter w{packet};
+  Tick const first{std::max(peer_ack_, local_known_ - std::min<Tick>(local_known_, window))};
+  auto const count{static_cast<std::uint8_t>(std::min<Tick>(local_known_ - first, 255))};
+  w.put(packet_magic);
+  w.put(first);
+  w.put(remote_confirmed_);
+  w.put(count);
+  for (Tick t{first}; t < first + count; ++t)
+    w.put(pack_input(local_inputs_[t % window]));
+  socket_.send(packet);
+  stats_.bytes_sent += packet.size();
+}
+
+sg::PlayerInput sg::LockstepSession::remote_input(Tick const t) const {
+  if (t < remote_confirmed_)
+    return remote_inputs_[t % window];
+  return remote_confirmed_ > 0 ? remote_inputs_[(remote_confirmed_ - 1) % window] : neutral_input;
+}
+
+void sg::LockstepSession::simulate(GameState &gs, Tick const t, GameEventBus &events) {
+  predicted_[t % window] = remote_input(t);
+  gs.set_player_input(local_inputs_[t % window], local_player_);
+  gs.set_player_input(predicted_[t % window], 1 - local_player_);
+  gs.update(lockstep_tick, events);
+}
+
+std::string sg::format_lockstep_stats(LockstepStats const &stats, IntUpdateDiff const &input_delay) {
+  auto const per_tick = [&stats](std::size_t const bytes) {
+    return stats.ticks == 0 ? 0.0 : static_cast<double>(bytes) / static_cast<double>(stats.ticks);
+  };
+  std::ostringstream result;
+  result.precision(1);
+  result << std::fixed << "lockstep: " << stats.ticks << " ticks, "
+         << per_tick(stats.bytes_sent) << " B/tick sent, "
+         << per_tick(stats.bytes_received) << " B/tick received, "
+         << "round trip " << average_ms(stats.round_trip_total, stats.round_trips) << " ms, "
+         << "input delay " << input_delay.count() << " ms, "
+         << stats.rollbacks << " rollbacks (" << stats.resimulated_ticks << " ticks replayed), "
+         << stats.stalls << " stalls";
+  return result.str();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "GameState.hpp"
+#include "Snapshot.hpp"
+#include "UdpSocket.hpp"
+#include "types.hpp"
+
+namespace sg {
+using Tick = std::uint32_t;
+
+struct LockstepStats {
+  std::size_t ticks{0};
+  std::size_t bytes_sent{0};
+  std::size_t bytes_received{0};
+  std::size_t rollbacks{0};
+  std::size_t resimulated_ticks{0};
+  std::size_t stalls{0};
+  std::size_t round_trips{0};
+  Clock::duration round_trip_total{0};
+};
+
+// Two-player lockstep over UDP. Every tick each side sends the inputs the
+// peer hasn't acknowledged yet; local input is applied `input_delay` ticks
+// late so it usually reaches the peer in time. Missing remote input is
+// predicted to repeat, and the simulation is rolled back and replayed from
+// snapshots when a prediction turns out wrong.
+class LockstepSession {
+public:
+  LockstepSession(UdpSocket, PlayerIndex local_player, Tick input_delay);
+
+  // Runs one tick of `lockstep_tick`, publishing its events; false and
+  // nothing run while more than `max_prediction` ticks ahead of the peer.
+  bool advance(GameState &, PlayerInput const &local, GameEventBus &);
+
+  [[nodiscard]] Tick tick() const { return tick_; }
+
+  // The tick the local input given to the next advance() applies to
+  [[nodiscard]] Tick next_input_tick() const { return local_known_; }
+
+  [[nodiscard]] LockstepStats const &stats() const { return stats_; }
+
+  [[nodiscard]] IntUpdateDiff input_delay() const;
+
+private:
+  static constexpr std::size_t window{64};
+
+  UdpSocket socket_;
+  PlayerIndex local_player_;
+  Tick input_delay_;
+  Tick tick_;
+  // Inputs are known for ticks below these
+  Tick local_known_;
+  Tick remote_confirmed_;
+  // Next tick the peer is missing from us
+  Tick peer_ack_;
+  std::array<PlayerInput, window> local_inputs_;
+  std::array<PlayerInput, window> remote_inputs_;
+  std::array<PlayerInput, window> predicted_;
+  std::array<TimePoint, window> sent_at_;
+  SnapshotHistory history_;
+  // Events of replayed ticks have already been published; they land here
+  GameEventBus replayed_events_;
+  LockstepStats stats_;
+
+  // Earliest tick whose prediction was wrong
+  std::optional<Tick> receive();
+
+  void send();
+
+  [[nodiscard]] PlayerInput remote_input(Tick) const;
+
+  void simulate(GameState &, Tick, GameEventBus &);
+};
+
+std::string format_lockstep_stats(LockstepStats const &, IntUpdateDiff const &input_delay);
+}
@@ -0,0 +1,284 @@
+#include "MetricsExporter.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+int const poll_timeout_ms{100};
+// Clients that connect but never send a request don't get to stall the thread
+timeval const http_read_timeout{1, 0};
+std::size_t const max_request_size{4096};
+
+std::string format_number(double const d) {
+  std::ostringstream result;
+  result << std::setprecision(9) << d;
+  return result.str();
+}
+
+std::runtime_error socket_error(std::string const &what) {
+  return std::runtime_error{what + ": " + std::strerror(errno)};
+}
+
+int listen_unix(std::filesystem::path const &path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.native().size() >= sizeof(address.sun_path))
+    throw std::runtime_error{"metrics socket path too long: " + path.string()};
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  int const fd{::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+  if (fd < 0)
+    throw socket_error("couldn't create metrics socket");
+  // Left over from an instance that didn't shut down cleanly
+  ::unlink(path.c_str());
+  if (::bind(fd, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) != 0 || ::listen(fd, 8) != 0) {
+    auto const error{socket_error("couldn't listen on " + path.string())};
+    ::close(fd);
+    throw error;
+  }
+  return fd;
+}
+
+int listen_http(std::uint16_t const port) {
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int const fd{::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+  if (fd < 0)
+    throw socket_error("couldn't create metrics socket");
+  int const reuse{1};
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  if (::bind(fd, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) != 0 || ::listen(fd, 8) != 0) {
+    auto const error{socket_error("couldn't listen on port " + std::to_string(port))};
+    ::close(fd);
+    throw error;
+  }
+  return fd;
+}
+
+// Best effort; a client that hangs up early just misses out.
+void send_all(int const fd, std::string const &data) {
+  std::size_t sent{0};
+  while (sent < data.size()) {
+    auto const n{::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL)};
+    if (n <= 0)
+      return;
+    sent += static_cast<std::size_t>(n);
+  }
+}
+
+void format_metric(std::string &out, std::string const &name, char const *type, std::string const &help,
+                   std::string const &value) {
+  out += "# HELP " + name + " " + help + "\n";
+  out += "# TYPE " + name + " " + type + "\n";
+  out += name + " " + value + "\n";
+}
+
+double hit_ratio(std::uint64_t const hits, std::uint64_t const misses) {
+  auto const total{hits + misses};
+  return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+}
+}
+
+sg::MetricsHistogram::MetricsHistogram(std::vector<double> _bounds)
+        : bounds_{std::move(_bounds)}, counts_(bounds_.size() + 1, 0), sum_{0} {}
+
+void sg::MetricsHistogram::observe(Clock::duration const &d) {
+  double const seconds{std::chrono::duration<double>(d).count()};
+  std::size_t bucket{0};
+  while (bucket < bounds_.size() && seconds > bounds_[bucket])
+    bucket++;
+  counts_[bucket]++;
+  sum_ += seconds;
+}
+
+void sg::MetricsHistogram::format(std::string &out, std::string const &name, std::string const &help) const {
+  out += "# HELP " + name + " " + help + "\n";
+  out += "# TYPE " + name + " histogram\n";
+  std::uint64_t cumulative{0};
+  for (std::size_t i{0}; i < counts_.size(); ++i) {
+    cumulative += counts_[i];
+    std::string const le{i < bounds_.size() ? format_number(bounds_[i]) : "+Inf"};
+    out += name + "_bucket{le=\"" + le + "\"} " + std::to_string(cumulative) + "\n";
+  }
+  out += name + "_sum " + format_number(sum_) + "\n";
+  out += name + "_count " + std::to_string(cumulative) + "\n";
+}
+
+sg::MetricsExporter::MetricsExporter(MetricsConfig _config)
+        : config_{std::move(_config)},
+          queue_{},
+          dropped_{0},
+          stop_{false},
+          unix_fd_{-1},
+          http_fd_{-1},
+          frame_time_{{0.005, 0.01, 0.0125, 0.0167, 0.025, 0.0333, 0.05, 0.1, 0.25}},
+          tick_time_{{0.0005, 0.001, 0.002, 0.004, 0.008, 0.016, 0.033}},
+          frames_{0},
+          last_{},
+          thread_{} {
+  if (config_.unix_socket.has_value())
+    unix_fd_ = listen_unix(config_.unix_socket.value());
+  if (config_.http_port.has_value()) {
+    try {
+      http_fd_ = listen_http(config_.http_port.value());
+    } catch (...) {
+      if (unix_fd_ >= 0)
+        ::close(unix_fd_);
+      throw;
+    }
+  }
+  thread_ = std::thread{[this]() { run(); }};
+}
+
+sg::MetricsExporter::~MetricsExporter() {
+  stop_ = true;
+  thread_.join();
+  if (unix_fd_ >= 0) {
+    ::close(unix_fd_);
+    ::unlink(config_.unix_socket->c_str());
+  }
+  if (http_fd_ >= 0)
+    ::close(http_fd_);
+}
+
+void sg::MetricsExporter::record(FrameMetrics const &m) {
+  if (!queue_.push(m))
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void sg::MetricsExporter::run() {
+  auto next_dump{Clock::now() + config_.dump_interval};
+  while (!stop_) {
+    std::vector<pollfd> fds;
+    if (unix_fd_ >= 0)
+      fds.push_back(pollfd{unix_fd_, POLLIN, 0});
+    if (http_fd_ >= 0)
+      fds.push_back(pollfd{http_fd_, POLLIN, 0});
+    if (fds.empty())
+      std::this_thread::sleep_for(std::chrono::milliseconds{poll_timeout_ms});
+    else
+      ::poll(fds.data(), fds.size(), poll_timeout_ms);
+    drain();
+    for (pollfd const &p : fds) {
+      if ((p.revents & POLLIN) == 0)
+        continue;
+      if (p.fd == unix_fd_)
+        serve_unix();
+      else
+        serve_http();
+    }
+    if (config_.dump_path.has_value() && Clock::now() >= next_dump) {
+      dump();
+      next_dump = Clock::now() + config_.dump_interval;
+    }
+  }
+  drain();
+  if (config_.dump_path.has_value())
+    dump();
+}
+
+void sg::MetricsExporter::drain() {
+  for (auto m{queue_.pop()}; m.has_value(); m = queue_.pop()) {
+    frame_time_.observe(m->frame_time);
+    tick_time_.observe(m->tick_time);
+    frames_++;
+    last_ = m;
+  }
+}
+
+std::string sg::MetricsExporter::format() const {
+  std::string result;
+  frame_time_.format(result, "spacegame_frame_seconds", "Time between consecutive frames.");
+  tick_time_.format(result, "spacegame_tick_seconds", "Time spent updating the game state per frame.");
+  format_metric(result, "spacegame_frames_total", "counter", "Frames recorded.", std::to_string(frames_));
+  format_metric(result, "spacegame_metrics_dropped_total", "counter",
+                "Frames not recorded because the exporter fell behind.",
+                std::to_string(dropped_.load(std::memory_order_relaxed)));
+  if (!last_.has_value())
+    return result;
+  FrameMetrics const &m{last_.value()};
+  format_metric(result, "spacegame_projectiles", "gauge", "Live projectiles.", std::to_string(m.projectiles));
+  format_metric(result, "spacegame_asteroids", "gauge", "Live asteroids.", std::to_string(m.asteroids));
+  format_metric(result, "spacegame_particles", "gauge", "Live particles.", std::to_string(m.particles));
+  format_metric(result, "spacegame_texture_cache_hits_total", "counter", "Texture cache hits.",
+                std::to_string(m.texture_hits));
+  format_metric(result, "spacegame_texture_cache_misses_total", "counter", "Texture cache misses.",
+                std::to_string(m.texture_misses));
+  format_metric(result, "spacegame_texture_cache_hit_ratio", "gauge", "Texture cache hits over all lookups.",
+                format_number(hit_ratio(m.texture_hits, m.texture_misses)));
+  format_metric(result, "spacegame_font_cache_hits_total", "counter", "Rendered text cache hits.",
+                std::to_string(m.font_hits));
+  format_metric(result, "spacegame_font_cache_misses_total", "counter", "Rendered text cache misses.",
+                std::to_string(m.font_misses));
+  format_metric(result, "spacegame_font_cache_hit_ratio", "gauge", "Rendered text cache hits over all lookups.",
+                format_number(hit_ratio(m.font_hits, m.font_misses)));
+  format_metric(result, "spacegame_sounds_played_total", "counter", "Sound effects started.",
+                std::to_string(m.sounds_played));
+  format_metric(result, "spacegame_voices_stolen_total", "counter", "Sound effects cut short for lack of voices.",
+                std::to_string(m.voices_stolen));
+  format_metric(result, "spacegame_asteroids_destroyed_total", "counter", "Asteroids shot down.",
+                std::to_string(m.asteroids_destroyed));
+  format_metric(result, "spacegame_points_scored_total", "counter", "Points scored, regardless of rewinds.",
+                std::to_string(m.points_scored));
+  return result;
+}
+
+void sg::MetricsExporter::serve_unix() const {
+  int const client{::accept4(unix_fd_, nullptr, nullptr, SOCK_CLOEXEC)};
+  if (client < 0)
+    return;
+  send_all(client, format());
+  ::close(client);
+}
+
+void sg::MetricsExporter::serve_http() const {
+  int const client{::accept4(http_fd_, nullptr, nullptr, SOCK_CLOEXEC)};
+  if (client < 0)
+    return;
+  ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &http_read_timeout, sizeof(http_read_timeout));
+  std::string request;
+  std::array<char, 512> buffer{};
+  while (request.find("\r\n\r\n") == std::string::npos && request.size() < max_request_size) {
+    auto const n{::recv(client, buffer.data(), buffer.size(), 0)};
+    if (n <= 0)
+      break;
+    request.append(buffer.data(), static_cast<std::size_t>(n));
+  }
+  std::string response;
+  if (request.rfind("GET /metrics ", 0) == 0 || request.rfind("GET / ", 0) == 0) {
+    std::string const body{format()};
+    response = "HTTP/1.1 200 OK\r\n"
+               "Content-Type: text/plain; version=0.0.4\r\n"
+               "Content-Length: " + std::to_string(body.size()) + "\r\n"
+               "Connection: close\r\n\r\n" + body;
+  } else {
+    response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+  }
+  send_all(client, response);
+  ::close(client);
+}
+
+void sg::MetricsExporter::dump() const {
+  // Written aside and renamed, so readers never see half a file
+  std::filesystem::path temporary{config_.dump_path.value()};
+  temporary += ".tmp";
+  {
+    std::ofstream out{temporary, std::ios::binary | std::ios::trunc};
+    if (!out)
+      return;
+    out << format();
+  }
+  std::error_code ignored;
+  std::filesystem::rename(temporary, config_.dump_path.value(), ignored);
+}
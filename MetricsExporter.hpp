@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spsc_queue.hpp"
+#include "types.hpp"
+#include "util.hpp"
+
+namespace sg {
+// What the game thread reports once per frame. Counters are running totals.
+struct FrameMetrics {
+  Clock::duration frame_time;
+  Clock::duration tick_time;
+  std::uint32_t projectiles;
+  std::uint32_t asteroids;
+  std::uint32_t particles;
+  std::uint64_t texture_hits;
+  std::uint64_t texture_misses;
+  std::uint64_t font_hits;
+  std::uint64_t font_misses;
+  std::uint64_t sounds_played;
+  std::uint64_t voices_stolen;
+  std::uint64_t asteroids_destroyed;
+  std::uint64_t points_scored;
+};
+
+struct MetricsConfig {
+  std::optional<std::filesystem::path> unix_socket;
+  // Bound to 127.0.0.1 only
+  std::optional<std::uint16_t> http_port;
+  std::optional<std::filesystem::path> dump_path;
+  std::chrono::seconds dump_interval{15};
+
+  [[nodiscard]] bool enabled() const {
+    return unix_socket.has_value() || http_port.has_value() || dump_path.has_value();
+  }
+};
+
+// Cumulative histogram over fixed upper bounds in seconds, as Prometheus
+// expects them.
+class MetricsHistogram {
+public:
+  explicit MetricsHistogram(std::vector<double> bounds);
+
+  void observe(Clock::duration const &);
+
+  void format(std::string &out, std::string const &name, std::string const &help) const;
+
+private:
+  std::vector<double> bounds_;
+  // One more than bounds, for +Inf
+  std::vector<std::uint64_t> counts_;
+  double sum_;
+};
+
+// Aggregates frame metrics on a background thread and serves them in the
+// Prometheus text format: on a Unix socket (the whole exposition is written
+// to each connection), over HTTP on localhost and/or by periodically
+// rewriting a file. record() never blocks the game thread.
+class MetricsExporter {
+public:
+  explicit MetricsExporter(MetricsConfig);
+
+  SG_NONCOPYABLE(MetricsExporter);
+  SG_NONMOVEABLE(MetricsExporter);
+
+  ~MetricsExporter();
+
+  // Dropped if the exporter thread has fallen a whole queue behind
+  void record(FrameMetrics const &);
+
+private:
+  MetricsConfig config_;
+  SpscQueue<FrameMetrics, 1024> queue_;
+  std::atomic<std::uint64_t> dropped_;
+  std::atomic<bool> stop_;
+  int unix_fd_;
+  int http_fd_;
+  // Only touched by the exporter thread
+  MetricsHistogram frame_time_;
+  MetricsHistogram tick_time_;
+  std::uint64_t frames_;
+  std::optional<FrameMetrics> last_;
+  std::thread thread_;
+
+  void run();
+
+  void drain();
+
+  [[nodiscard]] std::string format() const;
+
+  void serve_unix() const;
+
+  void serve_http() const;
+
+  void dump() const;
+};
+}
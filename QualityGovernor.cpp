@@ -0,0 +1,90 @@
+#include "QualityGovernor.hpp"
+
+#include <limits>
+#include <sstream>
+
+namespace {
+// The far star layer goes first, then particles, then resolution.
+std::array<sg::QualitySettings, 5> const quality_levels{{
+        {{1.0, 1.0, 1.0}, std::numeric_limits<std::size_t>::max(), 1.0f, sg::IntUpdateDiff{0}},
+        {{1.0, 1.0, 0.5}, 128, 1.0f, sg::IntUpdateDiff{0}},
+        {{1.0, 0.5, 0.25}, 64, 1.0f, sg::IntUpdateDiff{20}},
+        {{0.5, 0.5, 0.0}, 32, 0.75f, sg::IntUpdateDiff{33}},
+        {{0.5, 0.25, 0.0}, 16, 0.5f, sg::IntUpdateDiff{50}},
+}};
+
+std::size_t const window_frames{30};
+// Over budget for this many frames in a row steps down...
+std::size_t const degrade_after{10};
+// ...under this fraction of it for this many steps back up.
+double const improve_below{0.6};
+std::size_t const improve_after{180};
+}
+
+sg::QualityGovernor::QualityGovernor(Clock::duration const _budget)
+        : budget_{_budget},
+          recent_{},
+          recent_total_{0},
+          level_{0},
+          over_frames_{0},
+          under_frames_{0} {}
+
+bool sg::QualityGovernor::frame(Clock::duration const &work_time) {
+  recent_.push_back(work_time);
+  recent_total_ += work_time;
+  if (recent_.size() > window_frames) {
+    recent_total_ -= recent_.front();
+    recent_.pop_front();
+  }
+  auto const mean{average()};
+  over_frames_ = mean > budget_ ? over_frames_ + 1 : 0;
+  under_frames_ = std::chrono::duration<double>(mean) < improve_below * std::chrono::duration<double>(budget_)
+                  ? under_frames_ + 1 : 0;
+  if (over_frames_ >= degrade_after && level_ + 1 < level_count()) {
+    change_level(level_ + 1);
+    return true;
+  }
+  if (under_frames_ >= improve_after && level_ > 0) {
+    change_level(level_ - 1);
+    return true;
+  }
+  return false;
+}
+
+std::size_t sg::QualityGovernor::level_count() const {
+  return quality_levels.size();
+}
+
+sg::QualitySettings const &sg::QualityGovernor::settings() const {
+  return quality_levels[level_];
+}
+
+sg::Clock::duration sg::QualityGovernor::average() const {
+  return recent_.empty() ? Clock::duration{0} : recent_total_ / static_cast<Clock::rep>(recent_.size());
+}
+
+void sg::QualityGovernor::change_level(std::size_t const level) {
+  level_ = level;
+  // The old frame times say nothing about the new level
+  recent_.clear();
+  recent_total_ = Clock::duration{0};
+  over_frames_ = 0;
+  under_frames_ = 0;
+}
+
+std::string sg::format_quality(QualityGovernor const &governor) {
+  QualitySettings const &s{governor.settings()};
+  std::ostringstream result;
+  result << "quality level " << governor.level() << "/" << governor.level_count() - 1 << ": stars";
+  for (double const density : s.star_density)
+    result << " " << static_cast<int>(density * 100) << "%";
+  result << ", ";
+  if (s.particle_cap == std::numeric_limits<std::size_t>::max())
+    result << "all";
+  else
+    result << s.particle_cap;
+  result << " particles, " << static_cast<int>(s.render_scale * 100) << "% resolution";
+  if (s.background_step.count() > 0)
+    result << ", background every " << s.background_step.count() << " ms";
+  return result.str();
+}
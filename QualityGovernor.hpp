@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include "types.hpp"
+
+namespace sg {
+struct QualitySettings {
+  // Fraction of the stars drawn per starfield layer, nearest first
+  std::array<double, 3> star_density;
+  std::size_t particle_cap;
+  float render_scale;
+  // The starfield moves in steps of at least this long
+  IntUpdateDiff background_step;
+};
+
+// Watches how long frames take against a budget and steps quality down when
+// they keep running over it, and back up once they have been well under it
+// for a while. Level 0 is full quality.
+class QualityGovernor {
+public:
+  explicit QualityGovernor(Clock::duration budget);
+
+  // Returns true if the level changed.
+  bool frame(Clock::duration const &work_time);
+
+  [[nodiscard]] std::size_t level() const { return level_; }
+
+  [[nodiscard]] std::size_t level_count() const;
+
+  [[nodiscard]] QualitySettings const &settings() const;
+
+  // Mean over the last frames
+  [[nodiscard]] Clock::duration average() const;
+
+private:
+  Clock::duration budget_;
+  std::deque<Clock::duration> recent_;
+  Clock::duration recent_total_;
+  std::size_t level_;
+  std::size_t over_frames_;
+  std::size_t under_frames_;
+
+  void change_level(std::size_t);
+};
+
+std::string format_quality(QualityGovernor const &);
+}
@@ -8,6 +8,7 @@
 #include "TexturePath.hpp"
 #include "FontDescriptor.hpp"
 #include "Atlas.hpp"
+#include "memory_tracking.hpp"
 
 namespace sg {
 struct Image {
@@ -38,5 +39,5 @@ struct Text {
 
 using RenderObject = std::variant<Image, Solid, Text>;
 
-using RenderObjectList = std::vector<RenderObject>;
+using RenderObjectList = TaggedVector<RenderObject, MemoryTag::Render>;
 }
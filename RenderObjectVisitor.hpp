@@ -0,0 +1,29 @@
+#pragma once
+
+#include "SDL.hpp"
+#include "Atlas.hpp"
+#include "FontCache.hpp"
+#include "RenderObject.hpp"
+
+namespace sg {
+struct RenderObjectVisitor {
+  sg::SDLRenderer &renderer;
+  sg::AtlasCache &atlas_cache;
+  sg::FontCache &font_cache;
+
+  RenderObjectVisitor(sg::SDLRenderer &renderer, sg::AtlasCache &atlas_cache, sg::FontCache &font_cache) : renderer{
+          renderer}, atlas_cache{atlas_cache}, font_cache{font_cache} {}
+
+  void operator()(sg::Image const &image) const {
+    atlas_cache.get(image.atlas).render_tile(renderer, image.texture, image.rectangle);
+  }
+
+  void operator()(sg::Solid const &s) const {
+    renderer.fill_rect(s.rectangle, s.color);
+  }
+
+  void operator()(sg::Text const &t) const {
+    font_cache.copy_text(t.font, t.text, t.color, t.position);
+  }
+};
+}
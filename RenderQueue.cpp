@@ -0,0 +1,76 @@
+#include "RenderQueue.hpp"
+#include <array>
+#include <functional>
+#include <stdexcept>
+
+namespace {
+unsigned const layer_shift{56};
+unsigned const depth_shift{48};
+unsigned const texture_shift{24};
+sg::RenderQueue::TextureId const texture_mask{0xffffffu};
+// Every text is its own texture; they get ids from the upper half.
+sg::RenderQueue::TextureId const text_texture_bit{0x800000u};
+
+// LSD radix sort, one byte per pass. Passes where every key has the same
+// byte are skipped, which is most of them for a typical frame.
+template<typename Keys>
+void radix_sort(Keys &keys, Keys &scratch) {
+  std::array<std::array<std::size_t, 256>, 8> counts{};
+  for (std::uint64_t const k : keys)
+    for (unsigned byte{0}; byte < 8; ++byte)
+      counts[byte][(k >> (byte * 8)) & 0xffu]++;
+  scratch.resize(keys.size());
+  for (unsigned byte{0}; byte < 8; ++byte) {
+    auto &count{counts[byte]};
+    if (count[(keys.front() >> (byte * 8)) & 0xffu] == keys.size())
+      continue;
+    std::size_t offset{0};
+    for (std::size_t &c : count) {
+      auto const n{c};
+      c = offset;
+      offset += n;
+    }
+    for (std::uint64_t const k : keys)
+      scratch[count[(k >> (byte * 8)) & 0xffu]++] = k;
+    keys.swap(scratch);
+  }
+}
+}
+
+sg::RenderQueue::RenderQueue() : objects_{}, keys_{}, scratch_{}, atlases_{}, texture_switches_{0} {}
+
+void sg::RenderQueue::push(RenderLayer const layer, RenderObjectList &&objects, Depth const depth) {
+  if (objects_.size() + objects.size() > order_mask + 1)
+    throw std::runtime_error{"too many render objects in one frame"};
+  for (RenderObject &o : objects) {
+    auto const order{static_cast<SortKey>(objects_.size())};
+    keys_.push_back(static_cast<SortKey>(layer) << layer_shift |
+                    static_cast<SortKey>(depth) << depth_shift |
+                    static_cast<SortKey>(texture_id(o)) << texture_shift |
+                    order);
+    objects_.push_back(std::move(o));
+  }
+}
+
+sg::RenderQueue::TextureId sg::RenderQueue::texture_of(SortKey const key) {
+  return static_cast<TextureId>(key >> texture_shift) & texture_mask;
+}
+
+sg::RenderQueue::TextureId sg::RenderQueue::texture_id(RenderObject const &o) {
+  if (auto const *const image{std::get_if<Image>(&o)}) {
+    for (std::size_t i{0}; i < atlases_.size(); ++i)
+      if (atlases_[i] == image->atlas)
+        return static_cast<TextureId>(i + 1);
+    atlases_.push_back(image->atlas);
+    return static_cast<TextureId>(atlases_.size());
+  }
+  if (auto const *const text{std::get_if<Text>(&o)})
+    return text_texture_bit |
+           (static_cast<TextureId>(std::hash<std::string>{}(text->text) ^ text->font.size) & (text_texture_bit - 1));
+  return no_texture;
+}
+
+void sg::RenderQueue::sort() {
+  if (!keys_.empty())
+    radix_sort(keys_, scratch_);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <variant>
+#include <vector>
+#include "RenderObject.hpp"
+#include "util.hpp"
+
+namespace sg {
+enum class RenderLayer : std::uint8_t {
+  Background, Sprites, Effects, Hud, Console
+};
+
+// Collects a frame's render objects and draws them ordered by a 64 bit key:
+// layer (8 bits), depth (8 bits), texture (24 bits), submission order
+// (24 bits). Layers, and depths inside a layer, are drawn in order. Draws
+// sharing a layer and depth are grouped by texture, so there their paint
+// order only holds for the same texture: solids come first, then images,
+// then text. Lists whose draws overlap across textures need distinct depths.
+class RenderQueue {
+public:
+  using SortKey = std::uint64_t;
+  using TextureId = std::uint32_t;
+  using Depth = std::uint8_t;
+
+  RenderQueue();
+
+  void push(RenderLayer, RenderObjectList &&, Depth = 0);
+
+  template<typename F>
+  void flush(F const &f) {
+    sort();
+    texture_switches_ = 0;
+    std::optional<TextureId> current_texture;
+    for (SortKey const key : keys_) {
+      auto const texture{texture_of(key)};
+      if (texture != no_texture && texture != current_texture) {
+        texture_switches_++;
+        current_texture = texture;
+      }
+      std::visit(f, objects_[key & order_mask]);
+    }
+    objects_.clear();
+    keys_.clear();
+  }
+
+  // Texture changes during the last flush
+  [[nodiscard]] std::size_t texture_switches() const { return texture_switches_; }
+
+  SG_NONCOPYABLE(RenderQueue);
+
+private:
+  static constexpr TextureId no_texture{0};
+  static constexpr SortKey order_mask{0xffffffu};
+
+  RenderObjectList objects_;
+  TaggedVector<SortKey, MemoryTag::Render> keys_;
+  TaggedVector<SortKey, MemoryTag::Render> scratch_;
+  std::vector<AtlasDescriptor> atlases_;
+  std::size_t texture_switches_;
+
+  static TextureId texture_of(SortKey);
+
+  TextureId texture_id(RenderObject const &);
+
+  void sort();
+};
+}
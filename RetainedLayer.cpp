@@ -0,0 +1,40 @@
+#include "RetainedLayer.hpp"
+
+sg::RetainedLayer::RetainedLayer(SDLRenderer &_renderer, IntVector const &_size)
+        : renderer_{_renderer},
+          size_{_size},
+          texture_{},
+          revision_{},
+          objects_{},
+          empty_{true},
+          redraws_{0} {
+  if (renderer_.supports_targets())
+    texture_.emplace(renderer_.create_target(size_));
+}
+
+void sg::RetainedLayer::redraw(RenderObjectList objects, RenderObjectVisitor const &visitor) {
+  redraws_++;
+  empty_ = objects.empty();
+  if (!texture_.has_value()) {
+    objects_ = std::move(objects);
+    return;
+  }
+  // A hidden layer isn't copied at all, no need to clear it
+  if (empty_)
+    return;
+  renderer_.begin_target(texture_.value());
+  for (RenderObject const &o : objects)
+    std::visit(visitor, o);
+  renderer_.end_target();
+}
+
+void sg::RetainedLayer::composite(RenderObjectVisitor const &visitor) {
+  if (empty_)
+    return;
+  if (!texture_.has_value()) {
+    for (RenderObject const &o : objects_)
+      std::visit(visitor, o);
+    return;
+  }
+  renderer_.copy_whole(texture_.value(), IntRectangle::from_size_at_origin(size_));
+}
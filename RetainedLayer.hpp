@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include "SDL.hpp"
+#include "RenderObject.hpp"
+#include "RenderObjectVisitor.hpp"
+
+namespace sg {
+// Keeps a UI layer drawn into its own texture, redrawn only when the
+// layer's revision changes; otherwise the layer costs one copy per frame.
+// Objects are in game coordinates with the layer at the origin. Without
+// render target support, the objects are kept and drawn every frame.
+class RetainedLayer {
+public:
+  using Revision = std::uint64_t;
+
+  RetainedLayer(SDLRenderer &, IntVector const &size);
+
+  // Calls `objects` for a new RenderObjectList only if `revision` changed.
+  // Do this before the frame starts, as it switches render targets.
+  template<typename F>
+  void update(Revision const revision, F const &objects, RenderObjectVisitor const &visitor) {
+    if (revision_ == revision)
+      return;
+    revision_ = revision;
+    redraw(objects(), visitor);
+  }
+
+  // Forces a redraw on the next update, e.g. after fonts were reloaded
+  void invalidate() { revision_.reset(); }
+
+  void composite(RenderObjectVisitor const &);
+
+  [[nodiscard]] std::size_t redraws() const { return redraws_; }
+
+private:
+  SDLRenderer &renderer_;
+  IntVector size_;
+  std::optional<SDLTexture> texture_;
+  std::optional<Revision> revision_;
+  // Only kept when there is no texture
+  RenderObjectList objects_;
+  bool empty_;
+  std::size_t redraws_;
+
+  void redraw(RenderObjectList, RenderObjectVisitor const &);
+};
+}
@@ -2,7 +2,9 @@
 #include <SDL_image.h>
 #include <SDL_mixer.h>
 #include <SDL_ttf.h>
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <thread>
 
@@ -27,32 +29,185 @@ sg::IntVector get_texture_size(SDL_Texture *texture) {
   return sg::IntVector{w, h};
 }
 
+Uint32 get_texture_format(SDL_Texture *texture) {
+  Uint32 format;
+  if (SDL_QueryTexture(texture, &format, nullptr, nullptr, nullptr) < 0) {
+    throw std::runtime_error{"couldn't get texture information: " +
+                             sdl_error_string()};
+  }
+  return format;
+}
+
+Uint32 preferred_texture_format(SDL_Renderer *renderer) {
+  SDL_RendererInfo info;
+  if (SDL_GetRendererInfo(renderer, &info) != 0)
+    throw std::runtime_error{"couldn't get renderer information: " +
+                             sdl_error_string()};
+  for (Uint32 i{0}; i < info.num_texture_formats; ++i) {
+    Uint32 const f{info.texture_formats[i]};
+    if (SDL_ISPIXELFORMAT_ALPHA(f) && SDL_BYTESPERPIXEL(f) == 4)
+      return f;
+  }
+  return SDL_PIXELFORMAT_ARGB8888;
+}
+
+// Not every renderer (notably the software one) supports custom blend modes,
+// so try it on a scratch texture before committing to premultiplied alpha.
+std::optional<SDL_BlendMode> premultiplied_blend_mode(SDL_Renderer *renderer, Uint32 const format) {
+  SDL_BlendMode const mode{SDL_ComposeCustomBlendMode(
+          SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+          SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD)};
+  SDL_Texture *const probe{SDL_CreateTexture(renderer, format, SDL_TEXTUREACCESS_STATIC, 1, 1)};
+  if (probe == nullptr)
+    return std::nullopt;
+  bool const supported{SDL_SetTextureBlendMode(probe, mode) == 0};
+  SDL_DestroyTexture(probe);
+  return supported ? std::optional<SDL_BlendMode>{mode} : std::nullopt;
+}
+
+Uint32 alpha_of(SDL_PixelFormat const *f, Uint32 const pixel) {
+  return (pixel & f->Amask) >> f->Ashift;
+}
+
+bool has_translucent_pixels(SDL_Surface const *s) {
+  SDL_PixelFormat const *const f{s->format};
+  if (f->Amask == 0)
+    return false;
+  for (int y{0}; y < s->h; ++y) {
+    auto const *const row{reinterpret_cast<Uint32 const *>(static_cast<Uint8 const *>(s->pixels) + y * s->pitch)};
+    for (int x{0}; x < s->w; ++x)
+      if (alpha_of(f, row[x]) != 0xff)
+        return true;
+  }
+  return false;
+}
+
+void premultiply_alpha(SDL_Surface *s) {
+  SDL_PixelFormat const *const f{s->format};
+  Uint32 const color_mask{f->Rmask | f->Gmask | f->Bmask};
+  for (int y{0}; y < s->h; ++y) {
+    auto *const row{reinterpret_cast<Uint32 *>(static_cast<Uint8 *>(s->pixels) + y * s->pitch)};
+    for (int x{0}; x < s->w; ++x) {
+      Uint32 const p{row[x]};
+      Uint32 const a{alpha_of(f, p)};
+      if (a == 0xff)
+        continue;
+      Uint32 result{p & f->Amask};
+      for (Uint32 const mask : {f->Rmask, f->Gmask, f->Bmask}) {
+        Uint32 const shift{static_cast<Uint32>(__builtin_ctz(mask))};
+        Uint32 const c{(p & mask) >> shift};
+        result |= (((c * a + 127) / 255) << shift) & mask;
+      }
+      row[x] = result | (p & ~(color_mask | f->Amask));
+    }
+  }
+}
+
+SDL_Color current_draw_color(SDL_Renderer *renderer) {
+  SDL_Color c;
+  if (SDL_GetRenderDrawColor(renderer, &c.r, &c.g, &c.b, &c.a) != 0)
+    throw std::runtime_error{"couldn't get render draw color " +
+                             sdl_error_string()};
+  return c;
+}
+
+// The size frames are drawn at: the logical size if there is one
+sg::IntVector frame_size(SDL_Renderer *renderer) {
+  int w{0};
+  int h{0};
+  SDL_RenderGetLogicalSize(renderer, &w, &h);
+  if (w == 0 || h == 0) {
+    if (SDL_GetRendererOutputSize(renderer, &w, &h) != 0)
+      throw std::runtime_error{"couldn't get renderer output size: " +
+                               sdl_error_string()};
+  }
+  return sg::IntVector{w, h};
+}
+
+bool operator==(SDL_Color const &a, SDL_Color const &b) {
+  return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+bool operator!=(SDL_Color const &a, SDL_Color const &b) {
+  return !(a == b);
+}
+
 } // namespace
 
-sg::SDLRenderer::SDLRenderer(SDL_Renderer *const _renderer)
-        : _renderer(_renderer) {
+sg::SDLRenderer::SDLRenderer(SDL_Renderer *const _renderer,
+                             SurfaceConversion const _conversion,
+                             RenderBackend const _backend)
+        : _renderer(_renderer),
+          _conversion(_backend == RenderBackend::Tiled ? SurfaceConversion::NativePremultiplied : _conversion),
+          _native_format(_backend == RenderBackend::Tiled ? Uint32{SDL_PIXELFORMAT_ARGB8888}
+                                                          : preferred_texture_format(_renderer)),
+          // The rasterizer blends premultiplied pixels whatever SDL supports
+          _premultiplied_blend(_backend == RenderBackend::Tiled
+                               ? std::optional<SDL_BlendMode>{SDL_BLENDMODE_BLEND}
+                               : this->_conversion == SurfaceConversion::NativePremultiplied
+                                 ? premultiplied_blend_mode(_renderer, _native_format)
+                                 : std::nullopt),
+          _clear_color(current_draw_color(_renderer)),
+          _draw_color(_clear_color),
+          _pending_rects(),
+          _pending_color(_clear_color),
+          _draw_calls(0),
+          _render_scale(1.0f),
+          _scaled_target(),
+          _tiled(_backend == RenderBackend::Tiled ? std::make_unique<TiledRasterizer>(frame_size(_renderer))
+                                                  : nullptr),
+          _tiled_output() {
   if (SDL_SetRenderDrawBlendMode(this->_renderer, SDL_BLENDMODE_BLEND) != 0)
     throw std::runtime_error{"couldn't set blend mode: " +
                              sdl_error_string()};
+  if (_tiled)
+    create_tiled_output();
 }
 
-sg::SDLRenderer::~SDLRenderer() { SDL_DestroyRenderer(_renderer); }
+sg::SDLRenderer::~SDLRenderer() {
+  // Textures have to go before their renderer
+  _scaled_target.reset();
+  _tiled_output.reset();
+  SDL_DestroyRenderer(_renderer);
+}
 
 sg::SDLSurface::SDLSurface(SDL_Surface *const _surface) : _surface(_surface) {}
 
 sg::SDLSurface::~SDLSurface() { SDL_FreeSurface(_surface); }
 
 sg::SDLTexture::SDLTexture(SDL_Texture *const _texture)
-        : _texture(_texture), _size(get_texture_size(_texture)) {}
+        : _texture(_texture),
+          _image(),
+          _size(get_texture_size(_texture)),
+          _format(get_texture_format(_texture)),
+          _blend_mode(),
+          _color_mod() {}
+
+sg::SDLTexture::SDLTexture(std::shared_ptr<RasterImage const> _image)
+        : _texture(nullptr),
+          _image(std::move(_image)),
+          _size(this->_image->size),
+          _format(SDL_PIXELFORMAT_ARGB8888),
+          _blend_mode(),
+          _color_mod() {}
 
 sg::SDLTexture::SDLTexture(SDLTexture &&_texture) noexcept
-        : _texture(_texture._texture), _size(_texture._size) {
+        : _texture(_texture._texture),
+          _image(std::move(_texture._image)),
+          _size(_texture._size),
+          _format(_texture._format),
+          _blend_mode(_texture._blend_mode),
+          _color_mod(_texture._color_mod) {
   _texture._texture = nullptr;
 }
 
 sg::SDLTexture &sg::SDLTexture::operator=(SDLTexture &&other) noexcept {
-  _texture = other._texture;
-  other._texture = nullptr;
+  std::swap(_texture, other._texture);
+  std::swap(_image, other._image);
+  std::swap(_size, other._size);
+  std::swap(_format, other._format);
+  std::swap(_blend_mode, other._blend_mode);
+  std::swap(_color_mod, other._color_mod);
   return *this;
 }
 
@@ -72,19 +227,22 @@ sg::SDLWindow::SDLWindow(SDL_Window *const _window) : _window(_window) {}
 
 sg::SDLWindow::~SDLWindow() { SDL_DestroyWindow(_window); }
 
-sg::SDLRenderer sg::SDLWindow::create_renderer(IntVector const &v) {
-  SDL_Renderer *const renderer{
+sg::SDLRenderer sg::SDLWindow::create_renderer(IntVector const &v, RenderBackend const backend) {
+  SDL_Renderer *renderer{
           SDL_CreateRenderer(_window, -1, SDL_RENDERER_ACCELERATED)};
+  // Headless (SDL_VIDEODRIVER=dummy) there is only the software renderer
+  if (renderer == nullptr)
+    renderer = SDL_CreateRenderer(_window, -1, SDL_RENDERER_SOFTWARE);
   if (renderer == nullptr)
     throw std::runtime_error{"couldn't initialize renderer: " +
                              sdl_error_string()};
   if (SDL_RenderSetLogicalSize(renderer, v.x(), v.y()) < 0)
     throw std::runtime_error{"couldn't initialize renderer (logical size): " +
                              sdl_error_string()};
-  return SDLRenderer{renderer};
+  return SDLRenderer{renderer, SurfaceConversion::NativePremultiplied, backend};
 }
 
-sg::SDLImageContext::SDLImageContext() {
+sg::SDLImageContext::SDLImageContext(AssetPack const &_assets) : assets_{_assets} {
   int const imgFlags{IMG_INIT_PNG};
   if (!(IMG_Init(imgFlags) & imgFlags)) // NOLINT(hicpp-signed-bitwise)
     throw std::runtime_error{"couldn't initialize sdl image context: " +
@@ -93,22 +251,28 @@ sg::SDLImageContext::SDLImageContext() {
 
 sg::SDLImageContext::~SDLImageContext() { IMG_Quit(); }
 
-sg::SDLContext::SDLContext() {
+sg::SDLContext::SDLContext() : _events() {
   if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0)
     throw std::runtime_error{"couldn't initialize SDL: " +
                              sdl_error_string()};
 }
 
-std::vector<SDL_Event>
+std::vector<SDL_Event> const &
 sg::SDLContext::wait_event(std::chrono::milliseconds const &s) {
-  std::vector<SDL_Event> result;
+  _events.clear();
   SDL_Event event;
   while (SDL_PollEvent(&event)) {
-    result.push_back(event);
+    _events.push_back(event);
   }
-  if (result.empty())
+  if (_events.empty())
     std::this_thread::sleep_for(s);
-  return result;
+  return _events;
+}
+
+void sg::SDLContext::push_event(SDL_Event &e) {
+  if (SDL_PushEvent(&e) < 0)
+    throw std::runtime_error{"couldn't push event: " +
+                             sdl_error_string()};
 }
 
 sg::SDLContext::~SDLContext() { SDL_Quit(); }
@@ -129,56 +293,307 @@ sg::SDLWindow sg::SDLContext::create_window(IntVector const &v) {
 
 sg::SDLSurface
 sg::SDLImageContext::load_surface(std::filesystem::path const &p) {
-  SDL_Surface *const loaded{IMG_Load(p.c_str())};
+  SDL_Surface *const loaded{IMG_Load_RW(assets_.open(p), 1)};
   if (loaded == nullptr)
     throw std::runtime_error{"couldn't load image \"" + std::string{p} +
                              "\": " + std::string{IMG_GetError()}};
   return SDLSurface{loaded};
 }
 
+void sg::SDLImageContext::save_png(SDLSurface &s, std::filesystem::path const &p) {
+  if (IMG_SavePNG(s.surface(), p.c_str()) != 0)
+    throw std::runtime_error{"couldn't save image \"" + p.string() +
+                             "\": " + std::string{IMG_GetError()}};
+}
+
 sg::SDLTexture sg::SDLRenderer::create_texture(SDLSurface &s) {
-  SDL_Texture *const texture =
-          SDL_CreateTextureFromSurface(_renderer, s.surface());
+  if (_conversion == SurfaceConversion::None) {
+    SDL_Texture *const texture =
+            SDL_CreateTextureFromSurface(_renderer, s.surface());
+    if (texture == nullptr)
+      throw std::runtime_error{"couldn't convert surface to texture " +
+                               sdl_error_string()};
+    return SDLTexture{texture};
+  }
+  SDLSurface prepared{prepare_surface(s)};
+  return upload_surface(prepared);
+}
+
+sg::SDLSurface sg::SDLRenderer::prepare_surface(SDLSurface &s) const {
+  SDL_Surface *const converted{SDL_ConvertSurfaceFormat(s.surface(), _native_format, 0)};
+  if (converted == nullptr)
+    throw std::runtime_error{"couldn't convert surface to native format " +
+                             sdl_error_string()};
+  SDLSurface result{converted};
+  if (_premultiplied_blend.has_value())
+    premultiply_alpha(result.surface());
+  return result;
+}
+
+sg::SDLTexture sg::SDLRenderer::upload_surface(SDLSurface &s) {
+  SDL_Surface *const surface{s.surface()};
+  if (_tiled) {
+    std::vector<Uint32> pixels(static_cast<std::size_t>(surface->w) * static_cast<std::size_t>(surface->h));
+    for (int y{0}; y < surface->h; ++y)
+      std::copy_n(reinterpret_cast<Uint32 const *>(static_cast<Uint8 const *>(surface->pixels) + y * surface->pitch),
+                  surface->w,
+                  pixels.begin() + static_cast<std::ptrdiff_t>(y) * surface->w);
+    return SDLTexture{std::make_shared<RasterImage const>(
+            RasterImage{std::move(pixels), IntVector{surface->w, surface->h}, !has_translucent_pixels(surface)})};
+  }
+  SDL_Texture *const texture{SDL_CreateTexture(_renderer, _native_format, SDL_TEXTUREACCESS_STATIC, surface->w, surface->h)};
   if (texture == nullptr)
-    throw std::runtime_error{"couldn't convert surface to texture " +
+    throw std::runtime_error{"couldn't create texture " +
+                             sdl_error_string()};
+  SDLTexture result{texture};
+  if (SDL_UpdateTexture(texture, nullptr, surface->pixels, surface->pitch) != 0)
+    throw std::runtime_error{"couldn't upload surface to texture " +
                              sdl_error_string()};
-  return SDLTexture{texture};
+  // Opaque textures can be copied without blending at all.
+  result.blend_mode(!has_translucent_pixels(surface)
+                    ? SDL_BLENDMODE_NONE
+                    : _premultiplied_blend.value_or(SDL_BLENDMODE_BLEND));
+  return result;
 }
 
-void sg::SDLRenderer::clear() { SDL_RenderClear(_renderer); }
+void sg::SDLRenderer::clear() {
+  // Anything pending would be cleared anyway.
+  _pending_rects.clear();
+  if (_tiled) {
+    _tiled->clear(_clear_color);
+    return;
+  }
+  if (_scaled_target.has_value())
+    restore_target();
+  draw_color(_clear_color);
+  SDL_RenderClear(_renderer);
+}
 
 void sg::SDLRenderer::copy_whole(SDLTexture &t, IntRectangle const &r) {
+  if (_tiled) {
+    copy(t, IntRectangle::from_size_at_origin(t.size()), r);
+    return;
+  }
+  flush_rects();
   auto const dest_rect = to_sdl_rect(r);
   SDL_RenderCopy(_renderer, t.texture(), nullptr, &dest_rect);
+  _draw_calls++;
 }
 
 void sg::SDLRenderer::copy(SDLTexture &t, IntRectangle const &from, IntRectangle const &to) {
+  if (_tiled) {
+    _tiled->copy(t.image(), from, tiled_rect(to), t.color_mod());
+    _draw_calls++;
+    return;
+  }
+  flush_rects();
   auto const from_rect = to_sdl_rect(from);
   auto const to_rect = to_sdl_rect(to);
   SDL_RenderCopy(_renderer, t.texture(), &from_rect, &to_rect);
+  _draw_calls++;
+}
+
+void sg::SDLRenderer::present() {
+  if (_tiled) {
+    if (SDL_UpdateTexture(_tiled_output->texture(), nullptr, _tiled->finish(), _tiled->pitch()) != 0)
+      throw std::runtime_error{"couldn't upload frame " +
+                               sdl_error_string()};
+    SDL_RenderCopy(_renderer, _tiled_output->texture(), nullptr, nullptr);
+    SDL_RenderPresent(_renderer);
+    return;
+  }
+  flush_rects();
+  if (_scaled_target.has_value()) {
+    // Back on the window, SDL restores its logical size
+    if (SDL_SetRenderTarget(_renderer, nullptr) != 0)
+      throw std::runtime_error{"couldn't switch back to window render target " +
+                               sdl_error_string()};
+    SDL_RenderCopy(_renderer, _scaled_target->texture(), nullptr, nullptr);
+    _draw_calls++;
+  }
+  SDL_RenderPresent(_renderer);
+}
+
+sg::IntVector sg::SDLRenderer::read_pixels(std::vector<Uint32> &pixels) {
+  if (_tiled) {
+    Uint32 const *const frame{_tiled->finish()};
+    IntVector const size{_tiled->size()};
+    pixels.assign(frame, frame + static_cast<std::ptrdiff_t>(size.x()) * size.y());
+    return size;
+  }
+  flush_rects();
+  // The viewport is in scaled coordinates, the read back in actual pixels
+  SDL_Rect viewport;
+  float scale_x{1.0f};
+  float scale_y{1.0f};
+  SDL_RenderGetViewport(_renderer, &viewport);
+  SDL_RenderGetScale(_renderer, &scale_x, &scale_y);
+  IntVector const size{std::max(1, static_cast<int>(std::floor(static_cast<float>(viewport.w) * scale_x + 0.5f))),
+                       std::max(1, static_cast<int>(std::floor(static_cast<float>(viewport.h) * scale_y + 0.5f)))};
+  pixels.resize(static_cast<std::size_t>(size.x()) * static_cast<std::size_t>(size.y()));
+  if (SDL_RenderReadPixels(_renderer,
+                           nullptr,
+                           SDL_PIXELFORMAT_ARGB8888,
+                           pixels.data(),
+                           size.x() * static_cast<int>(sizeof(Uint32))) != 0)
+    throw std::runtime_error{"couldn't read back frame " +
+                             sdl_error_string()};
+  return size;
 }
 
-void sg::SDLRenderer::present() { SDL_RenderPresent(_renderer); }
+bool sg::SDLRenderer::supports_targets() const {
+  return !_tiled && SDL_RenderTargetSupported(_renderer) == SDL_TRUE && _premultiplied_blend.has_value();
+}
+
+sg::SDLTexture sg::SDLRenderer::create_target(IntVector const &size) {
+  if (_tiled)
+    throw std::runtime_error{"the tiled renderer has no render targets"};
+  SDL_Texture *const texture{SDL_CreateTexture(_renderer, _native_format, SDL_TEXTUREACCESS_TARGET, size.x(), size.y())};
+  if (texture == nullptr)
+    throw std::runtime_error{"couldn't create render target " +
+                             sdl_error_string()};
+  SDLTexture result{texture};
+  result.blend_mode(_premultiplied_blend.value_or(SDL_BLENDMODE_BLEND));
+  return result;
+}
+
+void sg::SDLRenderer::begin_target(SDLTexture &t) {
+  if (_tiled)
+    throw std::runtime_error{"the tiled renderer has no render targets"};
+  flush_rects();
+  if (SDL_SetRenderTarget(_renderer, t.texture()) != 0)
+    throw std::runtime_error{"couldn't switch render target " +
+                             sdl_error_string()};
+  // Straight alpha blended onto transparent black ends up premultiplied
+  draw_color(SDL_Color{0, 0, 0, 0});
+  SDL_RenderClear(_renderer);
+}
+
+void sg::SDLRenderer::end_target() {
+  flush_rects();
+  restore_target();
+}
+
+void sg::SDLRenderer::restore_target() {
+  if (!_scaled_target.has_value()) {
+    // SDL restores the window's logical size
+    if (SDL_SetRenderTarget(_renderer, nullptr) != 0)
+      throw std::runtime_error{"couldn't switch back to window render target " +
+                               sdl_error_string()};
+    return;
+  }
+  // Switching targets resets the scale, so it's set again every time.
+  if (SDL_SetRenderTarget(_renderer, _scaled_target->texture()) != 0 ||
+      SDL_RenderSetScale(_renderer, _render_scale, _render_scale) != 0)
+    throw std::runtime_error{"couldn't switch to scaled render target " +
+                             sdl_error_string()};
+}
+
+void sg::SDLRenderer::render_scale(float const scale) {
+  if (scale == _render_scale)
+    return;
+  _render_scale = scale;
+  if (_tiled) {
+    IntVector const size{frame_size(_renderer)};
+    _tiled->resize(IntVector{std::max(1, static_cast<int>(static_cast<float>(size.x()) * std::min(scale, 1.0f))),
+                             std::max(1, static_cast<int>(static_cast<float>(size.y()) * std::min(scale, 1.0f)))});
+    create_tiled_output();
+    return;
+  }
+  if (scale >= 1.0f) {
+    _scaled_target.reset();
+    return;
+  }
+  int w{0};
+  int h{0};
+  SDL_RenderGetLogicalSize(_renderer, &w, &h);
+  SDL_Texture *const texture{SDL_CreateTexture(_renderer,
+                                               _native_format,
+                                               SDL_TEXTUREACCESS_TARGET,
+                                               std::max(1, static_cast<int>(static_cast<float>(w) * scale)),
+                                               std::max(1, static_cast<int>(static_cast<float>(h) * scale)))};
+  if (texture == nullptr)
+    throw std::runtime_error{"couldn't create scaled render target " +
+                             sdl_error_string()};
+  _scaled_target.emplace(texture);
+  _scaled_target->blend_mode(SDL_BLENDMODE_NONE);
+}
 
 void sg::SDLRenderer::fill_rect(IntRectangle const &ext_rect, SDL_Color const &c) {
-  const SDL_Rect &rect = to_sdl_rect(ext_rect);
-  Uint8 r, g, b, a;
-  if (SDL_GetRenderDrawColor(this->_renderer, &r, &g, &b, &a) != 0)
-    throw std::runtime_error{"couldn't get render draw color " +
+  if (_tiled) {
+    _tiled->fill(tiled_rect(ext_rect), c);
+    _draw_calls++;
+    return;
+  }
+  if (!_pending_rects.empty() && _pending_color != c)
+    flush_rects();
+  _pending_color = c;
+  _pending_rects.push_back(to_sdl_rect(ext_rect));
+}
+
+void sg::SDLRenderer::create_tiled_output() {
+  _tiled_output.reset();
+  SDL_Texture *const texture{SDL_CreateTexture(_renderer,
+                                               SDL_PIXELFORMAT_ARGB8888,
+                                               SDL_TEXTUREACCESS_STREAMING,
+                                               _tiled->size().x(),
+                                               _tiled->size().y())};
+  if (texture == nullptr)
+    throw std::runtime_error{"couldn't create frame texture " +
                              sdl_error_string()};
+  _tiled_output.emplace(texture);
+  _tiled_output->blend_mode(SDL_BLENDMODE_NONE);
+}
+
+sg::IntRectangle sg::SDLRenderer::tiled_rect(IntRectangle const &r) const {
+  if (_render_scale >= 1.0f)
+    return r;
+  return rect_map(r, [this](int const v) {
+    return static_cast<int>(std::floor(static_cast<float>(v) * _render_scale + 0.5f));
+  });
+}
+
+void sg::SDLRenderer::draw_color(SDL_Color const &c) {
+  if (_draw_color == c)
+    return;
   if (SDL_SetRenderDrawColor(this->_renderer, c.r, c.g, c.b, c.a) != 0)
     throw std::runtime_error{"couldn't set render draw color " +
                              sdl_error_string()};
-  if (SDL_RenderFillRect(this->_renderer, &rect) != 0)
-    throw std::runtime_error{"couldn't fill rect " +
+  _draw_color = c;
+}
+
+void sg::SDLRenderer::flush_rects() {
+  if (_pending_rects.empty())
+    return;
+  draw_color(_pending_color);
+  if (SDL_RenderFillRects(this->_renderer, _pending_rects.data(), static_cast<int>(_pending_rects.size())) != 0)
+    throw std::runtime_error{"couldn't fill rects " +
                              sdl_error_string()};
-  if (SDL_SetRenderDrawColor(this->_renderer, r, g, b, a) != 0)
-    throw std::runtime_error{"couldn't set render draw color " +
+  _draw_calls++;
+  _pending_rects.clear();
+}
+
+void sg::SDLTexture::blend_mode(SDL_BlendMode const mode) {
+  if (_blend_mode == mode)
+    return;
+  if (_texture != nullptr && SDL_SetTextureBlendMode(_texture, mode) != 0)
+    throw std::runtime_error{"couldn't set texture blend mode " +
                              sdl_error_string()};
+  _blend_mode = mode;
+}
 
+void sg::SDLTexture::color_mod(SDL_Color const &c) {
+  if (_color_mod.has_value() && _color_mod.value() == c)
+    return;
+  if (_texture != nullptr &&
+      (SDL_SetTextureColorMod(_texture, c.r, c.g, c.b) != 0 || SDL_SetTextureAlphaMod(_texture, c.a) != 0))
+    throw std::runtime_error{"couldn't set texture color mod " +
+                             sdl_error_string()};
+  _color_mod = c;
 }
 
-sg::SDLMixerContext::SDLMixerContext(SDLContext const &) : lib_inited_{false}, music_{nullptr} {
+sg::SDLMixerContext::SDLMixerContext(SDLContext const &, AssetPack const &_assets)
+        : assets_{_assets}, lib_inited_{false}, music_{nullptr} {
   if (Mix_Init(MIX_INIT_OPUS) != MIX_INIT_OPUS)
     throw std::runtime_error{"couldn't initialize SDL mixer: " + std::string{Mix_GetError()}};
   lib_inited_ = true;
@@ -198,7 +613,7 @@ void sg::SDLMixerContext::play_music(std::filesystem::path const &p) {
     Mix_FreeMusic(music_);
     music_ = nullptr;
   }
-  music_ = Mix_LoadMUS(p.c_str());
+  music_ = Mix_LoadMUS_RW(assets_.open(p), 1);
   if (music_ == nullptr)
     throw std::runtime_error{"couldn't load music " + p.string() + ": " + std::string{Mix_GetError()}};
   if (Mix_PlayMusic(music_, -1) == -1)
@@ -206,35 +621,40 @@ void sg::SDLMixerContext::play_music(std::filesystem::path const &p) {
   Mix_VolumeMusic(MIX_MAX_VOLUME / 10);
 }
 
-sg::SDLMixerChunk::SDLMixerChunk(Mix_Chunk *_chunk) : chunk_(_chunk) {
-}
-
-sg::SDLMixerChunk::SDLMixerChunk(SDLMixerChunk &&other) noexcept : chunk_(other.chunk_) {
-  other.chunk_ = nullptr;
-}
-
-sg::SDLMixerChunk &sg::SDLMixerChunk::operator=(SDLMixerChunk &&other) noexcept {
-  this->chunk_ = other.chunk_;
-  other.chunk_ = nullptr;
-  return *this;
-}
-
-sg::SDLMixerChunk::~SDLMixerChunk() {
-  Mix_FreeChunk(chunk_);
-}
-
-sg::SDLMixerChunk sg::SDLMixerContext::load_chunk(std::filesystem::path const &p) {
-  Mix_Chunk *const chunk = Mix_LoadWAV(p.c_str());
+sg::MixerSound sg::SDLMixerContext::load_sound(std::filesystem::path const &p) {
+  int frequency;
+  Uint16 format;
+  int channels;
+  if (Mix_QuerySpec(&frequency, &format, &channels) == 0)
+    throw std::runtime_error{"audio isn't open: " + std::string{Mix_GetError()}};
+  if (format != AUDIO_S16SYS)
+    throw std::runtime_error{"unsupported audio format " + std::to_string(format)};
+  std::unique_ptr<Mix_Chunk, decltype(&Mix_FreeChunk)> const chunk{Mix_LoadWAV_RW(assets_.open(p), 1), Mix_FreeChunk};
   if (chunk == nullptr)
     throw std::runtime_error{"couldn't load " + p.string() + ": " + std::string{Mix_GetError()}};
-  return sg::SDLMixerChunk(chunk);
+  auto const frames{chunk->alen / (sizeof(Sint16) * static_cast<std::size_t>(channels))};
+  return MixerSound::from_s16(reinterpret_cast<Sint16 const *>(chunk->abuf), frames, channels);
 }
 
-void sg::SDLMixerContext::play_chunk(SDLMixerChunk &chunk) {
-  Mix_PlayChannel(-1, chunk.chunk(), 0);
-}
-
-sg::SDLTTFContext::SDLTTFContext() {
+void sg::SDLMixerContext::post_mix(AudioMixer *mixer) {
+  if (mixer == nullptr) {
+    Mix_SetPostMix(nullptr, nullptr);
+    return;
+  }
+  int frequency;
+  Uint16 format;
+  int channels;
+  if (Mix_QuerySpec(&frequency, &format, &channels) == 0)
+    throw std::runtime_error{"audio isn't open: " + std::string{Mix_GetError()}};
+  if (format != AUDIO_S16SYS || channels != 2)
+    throw std::runtime_error{"the mixer needs 16 bit stereo output"};
+  Mix_SetPostMix([](void *m, Uint8 *stream, int length) {
+    static_cast<AudioMixer *>(m)->mix(reinterpret_cast<std::int16_t *>(stream),
+                                      static_cast<std::size_t>(length) / (2 * sizeof(std::int16_t)));
+  }, mixer);
+}
+
+sg::SDLTTFContext::SDLTTFContext(AssetPack const &_assets) : assets_{_assets} {
   if (TTF_Init() == -1)
     throw std::runtime_error{"couldn't init TTF: " + std::string{TTF_GetError()}};
 }
@@ -244,7 +664,7 @@ sg::SDLTTFContext::~SDLTTFContext() {
 }
 
 sg::SDLTTFFont sg::SDLTTFContext::open_font(std::filesystem::path const &p, unsigned const pt) {
-  TTF_Font *const font{TTF_OpenFont(p.c_str(), static_cast<int>(pt))};
+  TTF_Font *const font{TTF_OpenFontRW(assets_.open(p), 1, static_cast<int>(pt))};
   if (font == nullptr)
     throw std::runtime_error{"couldn't load " + p.string() + ": " + std::string{TTF_GetError()}};
   return SDLTTFFont{font};
@@ -2,6 +2,9 @@
 
 #include "math.hpp"
 #include "util.hpp"
+#include "AssetPack.hpp"
+#include "AudioMixer.hpp"
+#include "TiledRasterizer.hpp"
 #include <SDL.h>
 #include <chrono>
 #include <filesystem>
@@ -16,10 +19,27 @@ class SDLTexture {
 public:
   explicit SDLTexture(SDL_Texture *);
 
+  // A texture of the tiled backend, which SDL never sees
+  explicit SDLTexture(std::shared_ptr<RasterImage const>);
+
+  // nullptr for textures of the tiled backend
   SDL_Texture *texture() { return _texture; }
 
+  [[nodiscard]] std::shared_ptr<RasterImage const> const &image() const { return _image; }
+
   [[nodiscard]] IntVector size() const { return _size; }
 
+  [[nodiscard]] Uint32 format() const { return _format; }
+
+  // Both setters skip the SDL call if the value is already set.
+  void blend_mode(SDL_BlendMode);
+
+  void color_mod(SDL_Color const &);
+
+  [[nodiscard]] std::optional<SDL_BlendMode> blend_mode() const { return _blend_mode; }
+
+  [[nodiscard]] std::optional<SDL_Color> color_mod() const { return _color_mod; }
+
   SG_NONCOPYABLE(SDLTexture);
 
   SDLTexture(SDLTexture &&) noexcept;
@@ -30,7 +50,11 @@ public:
 
 private:
   SDL_Texture *_texture;
+  std::shared_ptr<RasterImage const> _image;
   IntVector _size;
+  Uint32 _format;
+  std::optional<SDL_BlendMode> _blend_mode;
+  std::optional<SDL_Color> _color_mod;
 };
 
 class SDLSurface {
@@ -45,20 +69,55 @@ public:
 
   SDL_Surface *surface() { return _surface; }
 
+  [[nodiscard]] SDL_Surface const *surface() const { return _surface; }
+
   ~SDLSurface();
 
 private:
   SDL_Surface *_surface;
 };
 
+enum class SurfaceConversion {
+  // Hand surfaces to SDL as loaded, converting implicitly
+  None,
+  // Convert to the renderer's preferred format and premultiply alpha once
+  NativePremultiplied
+};
+
+enum class RenderBackend {
+  // SDL's own renderer does the drawing
+  Sdl,
+  // Frames are rasterized on the CPU by a TiledRasterizer and handed to SDL
+  // as one streaming texture; surfaces are always converted and premultiplied.
+  Tiled
+};
+
 class SDLRenderer {
 public:
-  explicit SDLRenderer(SDL_Renderer *);
+  explicit SDLRenderer(SDL_Renderer *,
+                       SurfaceConversion = SurfaceConversion::NativePremultiplied,
+                       RenderBackend = RenderBackend::Sdl);
 
   SG_NONCOPYABLE(SDLRenderer); SG_NONMOVEABLE(SDLRenderer);
 
   SDLTexture create_texture(SDLSurface &);
 
+  // Only touches the surface, so it may run on a worker thread.
+  [[nodiscard]] SDLSurface prepare_surface(SDLSurface &) const;
+
+  // Expects a surface returned by prepare_surface.
+  SDLTexture upload_surface(SDLSurface &);
+
+  [[nodiscard]] Uint32 native_format() const { return _native_format; }
+
+  [[nodiscard]] bool premultiplied_alpha() const { return _premultiplied_blend.has_value(); }
+
+  [[nodiscard]] RenderBackend backend() const { return _tiled ? RenderBackend::Tiled : RenderBackend::Sdl; }
+
+  // SDL draw calls issued since construction; with the tiled backend, the
+  // commands it rasterized
+  [[nodiscard]] std::size_t draw_calls() const { return _draw_calls; }
+
   void clear();
 
   void copy_whole(SDLTexture &, IntRectangle const &);
@@ -67,12 +126,62 @@ public:
 
   void present();
 
+  // Reads back the frame drawn so far as ARGB8888, so call it right before
+  // present(). Resizes `pixels` to fit and returns the frame's size.
+  IntVector read_pixels(std::vector<Uint32> &pixels);
+
+  // Consecutive rectangles of the same color are drawn with a single
+  // SDL_RenderFillRects once something else is drawn or the frame is
+  // presented.
   void fill_rect(IntRectangle const &, SDL_Color const &);
 
+  // Render targets are drawn with premultiplied alpha, so this also needs
+  // premultiplied blending. The tiled backend has none.
+  [[nodiscard]] bool supports_targets() const;
+
+  // A transparent texture for begin_target
+  SDLTexture create_target(IntVector const &);
+
+  // Draws into the texture, cleared to transparent, until end_target.
+  void begin_target(SDLTexture &);
+
+  void end_target();
+
+  // Below 1, frames are drawn into a smaller texture that present() stretches
+  // over the window.
+  void render_scale(float);
+
+  [[nodiscard]] float render_scale() const { return _render_scale; }
+
   ~SDLRenderer();
 
 private:
   SDL_Renderer *_renderer;
+  SurfaceConversion _conversion;
+  Uint32 _native_format;
+  std::optional<SDL_BlendMode> _premultiplied_blend;
+  SDL_Color _clear_color;
+  SDL_Color _draw_color;
+  std::vector<SDL_Rect> _pending_rects;
+  SDL_Color _pending_color;
+  std::size_t _draw_calls;
+  float _render_scale;
+  std::optional<SDLTexture> _scaled_target;
+  std::unique_ptr<TiledRasterizer> _tiled;
+  // What the tiled backend's frames are uploaded to
+  std::optional<SDLTexture> _tiled_output;
+
+  void draw_color(SDL_Color const &);
+
+  void flush_rects();
+
+  // The frame's own target: the scaled texture or the window
+  void restore_target();
+
+  void create_tiled_output();
+
+  // Scales game coordinates to the tiled backend's framebuffer
+  [[nodiscard]] IntRectangle tiled_rect(IntRectangle const &) const;
 };
 
 class SDLWindow {
@@ -83,7 +192,7 @@ public:
 
   ~SDLWindow();
 
-  SDLRenderer create_renderer(IntVector const &);
+  SDLRenderer create_renderer(IntVector const &, RenderBackend = RenderBackend::Sdl);
 
 private:
   SDL_Window *_window;
@@ -92,11 +201,16 @@ private:
 class SDLImageContext {
 public: SG_NONCOPYABLE(SDLImageContext); SG_NONMOVEABLE(SDLImageContext);
 
-  SDLImageContext();
+  explicit SDLImageContext(AssetPack const &);
 
   SDLSurface load_surface(std::filesystem::path const &);
 
+  void save_png(SDLSurface &, std::filesystem::path const &);
+
   ~SDLImageContext();
+
+private:
+  AssetPack const &assets_;
 };
 
 class SDLContext {
@@ -106,58 +220,53 @@ public: SG_NONCOPYABLE(SDLContext); SG_NONMOVEABLE(SDLContext);
 
   ~SDLContext();
 
-  std::vector<SDL_Event> wait_event(std::chrono::milliseconds const &);
+  // The events are valid until the next call; the buffer is reused.
+  std::vector<SDL_Event> const &wait_event(std::chrono::milliseconds const &);
+
+  void push_event(SDL_Event &);
 
   SDLWindow create_window(IntVector const &);
-};
 
-class SDLMixerChunk;
+private:
+  std::vector<SDL_Event> _events;
+};
 
 class SDLMixerContext {
 public: SG_NONCOPYABLE(SDLMixerContext); SG_NONMOVEABLE(SDLMixerContext);
 
-  explicit SDLMixerContext(SDLContext const &);
+  SDLMixerContext(SDLContext const &, AssetPack const &);
 
   ~SDLMixerContext();
 
   void play_music(std::filesystem::path const &);
 
-  SDLMixerChunk load_chunk(std::filesystem::path const &);
+  // Decodes into the mixer's own sample format
+  MixerSound load_sound(std::filesystem::path const &);
 
-  void play_chunk(SDLMixerChunk &);
+  // Mixes the voices of `mixer` over everything SDL_mixer plays; nullptr
+  // removes it again. Once this returns, the previous mixer is no longer
+  // called.
+  void post_mix(AudioMixer *mixer);
 
 private:
+  AssetPack const &assets_;
   bool lib_inited_;
   Mix_Music *music_;
 };
 
-class SDLMixerChunk {
-public: SG_NONCOPYABLE(SDLMixerChunk);
-
-  explicit SDLMixerChunk(Mix_Chunk *);
-
-  SDLMixerChunk(SDLMixerChunk &&) noexcept;
-
-  SDLMixerChunk &operator=(SDLMixerChunk &&) noexcept;
-
-  Mix_Chunk *chunk() { return chunk_; }
-
-  ~SDLMixerChunk();
-
-private:
-  Mix_Chunk *chunk_;
-};
-
 class SDLTTFFont;
 
 class SDLTTFContext {
 public: SG_NONCOPYABLE(SDLTTFContext); SG_NONMOVEABLE(SDLTTFContext);
 
-  SDLTTFContext();
+  explicit SDLTTFContext(AssetPack const &);
 
   SDLTTFFont open_font(std::filesystem::path const &, unsigned size);
 
   ~SDLTTFContext();
+
+private:
+  AssetPack const &assets_;
 };
 
 class SDLTTFFont {
@@ -0,0 +1,98 @@
+#include "Snapshot.hpp"
+
+namespace {
+void put_varint(sg::Snapshot &out, std::size_t v) {
+  while (v >= 0x80) {
+    out.push_back(static_cast<std::uint8_t>(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back(static_cast<std::uint8_t>(v));
+}
+
+std::size_t get_varint(sg::Snapshot const &in, std::size_t &position) {
+  std::size_t result{0};
+  for (unsigned shift{0};; shift += 7) {
+    if (position >= in.size())
+      throw std::runtime_error{"snapshot delta is truncated"};
+    auto const byte{in[position++]};
+    result |= static_cast<std::size_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+      return result;
+  }
+}
+
+std::uint8_t base_byte(sg::Snapshot const &base, std::size_t const i) {
+  return i < base.size() ? base[i] : 0;
+}
+}
+
+// Layout: target size, then pairs of (zero run length, literal count,
+// literal XORed bytes) until the target size is reached.
+sg::Snapshot sg::delta_encode(Snapshot const &base, Snapshot const &target) {
+  Snapshot result;
+  put_varint(result, target.size());
+  std::size_t i{0};
+  while (i < target.size()) {
+    std::size_t const run_start{i};
+    while (i < target.size() && target[i] == base_byte(base, i))
+      ++i;
+    put_varint(result, i - run_start);
+    std::size_t const literal_start{i};
+    while (i < target.size() && target[i] != base_byte(base, i))
+      ++i;
+    put_varint(result, i - literal_start);
+    for (std::size_t j{literal_start}; j < i; ++j)
+      result.push_back(static_cast<std::uint8_t>(target[j] ^ base_byte(base, j)));
+  }
+  return result;
+}
+
+sg::Snapshot sg::delta_decode(Snapshot const &base, Snapshot const &delta) {
+  std::size_t position{0};
+  Snapshot result(get_varint(delta, position));
+  std::size_t i{0};
+  while (i < result.size()) {
+    auto const run{get_varint(delta, position)};
+    auto const literals{get_varint(delta, position)};
+    if (run + literals > result.size() - i || literals > delta.size() - position)
+      throw std::runtime_error{"snapshot delta is corrupt"};
+    for (std::size_t end{i + run}; i < end; ++i)
+      result[i] = base_byte(base, i);
+    for (std::size_t end{i + literals}; i < end; ++i)
+      result[i] = static_cast<std::uint8_t>(delta[position++] ^ base_byte(base, i));
+  }
+  return result;
+}
+
+sg::SnapshotHistory::SnapshotHistory(std::size_t const _capacity)
+        : capacity_{_capacity}, deltas_{}, newest_{}, has_newest_{false} {}
+
+void sg::SnapshotHistory::push(Snapshot s) {
+  if (has_newest_)
+    deltas_.push_back(delta_encode(s, newest_));
+  newest_ = std::move(s);
+  has_newest_ = true;
+  while (size() > capacity_)
+    deltas_.pop_front();
+}
+
+sg::Snapshot sg::SnapshotHistory::rewind(std::size_t const ticks) {
+  if (!has_newest_)
+    throw std::runtime_error{"no snapshots to rewind to"};
+  for (std::size_t i{0}; i < ticks && !deltas_.empty(); ++i) {
+    newest_ = delta_decode(newest_, deltas_.back());
+    deltas_.pop_back();
+  }
+  return newest_;
+}
+
+std::size_t sg::SnapshotHistory::size() const {
+  return deltas_.size() + (has_newest_ ? 1 : 0);
+}
+
+std::size_t sg::SnapshotHistory::byte_size() const {
+  std::size_t result{newest_.size()};
+  for (Snapshot const &d : deltas_)
+    result += d.size();
+  return result;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace sg {
+using Snapshot = std::vector<std::uint8_t>;
+
+class SnapshotWriter {
+public:
+  explicit SnapshotWriter(Snapshot &_out) : out_{_out} {}
+
+  template<typename T>
+  void put(T const &t) {
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values can be written directly");
+    auto const *const bytes{reinterpret_cast<std::uint8_t const *>(&t)};
+    out_.insert(out_.end(), bytes, bytes + sizeof(T));
+  }
+
+  void put_string(std::string const &s) {
+    put(static_cast<std::uint32_t>(s.size()));
+    out_.insert(out_.end(), s.begin(), s.end());
+  }
+
+private:
+  Snapshot &out_;
+};
+
+class SnapshotReader {
+public:
+  explicit SnapshotReader(Snapshot const &_in) : in_{_in}, position_{0} {}
+
+  template<typename T>
+  T get() {
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values can be read directly");
+    alignas(T) std::uint8_t storage[sizeof(T)];
+    std::memcpy(storage, bytes(sizeof(T)), sizeof(T));
+    return *std::launder(reinterpret_cast<T *>(storage));
+  }
+
+  std::string get_string() {
+    auto const size{get<std::uint32_t>()};
+    return std::string{reinterpret_cast<char const *>(bytes(size)), size};
+  }
+
+private:
+  Snapshot const &in_;
+  std::size_t position_;
+
+  std::uint8_t const *bytes(std::size_t const n) {
+    if (in_.size() - position_ < n)
+      throw std::runtime_error{"snapshot is truncated"};
+    auto const result{in_.data() + position_};
+    position_ += n;
+    return result;
+  }
+};
+
+// Encodes `target` relative to `base`: the bytes are XORed and runs of
+// zeroes (unchanged bytes) are run-length encoded.
+Snapshot delta_encode(Snapshot const &base, Snapshot const &target);
+
+Snapshot delta_decode(Snapshot const &base, Snapshot const &delta);
+
+// The last `capacity` snapshots. Only the newest is kept in full; each older
+// one is stored as a delta against its successor, so rewinding a few ticks
+// decodes only a few deltas.
+class SnapshotHistory {
+public:
+  explicit SnapshotHistory(std::size_t capacity);
+
+  void push(Snapshot);
+
+  // Drops the newest `ticks` snapshots and returns the one that is newest
+  // afterwards.
+  Snapshot rewind(std::size_t ticks);
+
+  [[nodiscard]] std::size_t size() const;
+
+  // Bytes held, deltas plus the newest full snapshot
+  [[nodiscard]] std::size_t byte_size() const;
+
+private:
+  std::size_t capacity_;
+  std::deque<Snapshot> deltas_;
+  Snapshot newest_;
+  bool has_newest_;
+};
+}
@@ -1,6 +1,7 @@
 #include "Starfield.hpp"
 #include "constants.hpp"
 #include "Atlas.hpp"
+#include <algorithm>
 
 namespace {
 unsigned star_count_per_layer(unsigned const layer_index) {
@@ -29,24 +30,33 @@ sg::DoubleVector sg::Starfield::random_top_position(unsigned const layer_index)
 sg::Starfield::Starfield(RandomEngine &_random_engine)
         : random_engine_{_random_engine},
           distribution_x{0, static_cast<double>(game_size.x())},
-          distribution_y{0, static_cast<double>(game_size.y())} {
+          distribution_y{0, static_cast<double>(game_size.y())},
+          active_{},
+          step_{0},
+          pending_{0} {
   for (unsigned layer_index = 0; layer_index < 3; ++layer_index) {
     LayerVector new_layer;
     for (unsigned star_index = 0; star_index < star_count_per_layer(layer_index); ++star_index) {
       new_layer.push_back(random_position());
     }
+    active_[layer_index] = new_layer.size();
     layers_.push_back(std::move(new_layer));
   }
 }
 
-void sg::Starfield::update(IntUpdateDiff const &d) {
+void sg::Starfield::update(IntUpdateDiff const &frame_diff) {
+  pending_ += frame_diff;
+  if (pending_ < step_)
+    return;
+  IntUpdateDiff const d{pending_};
+  pending_ = IntUpdateDiff{0};
   unsigned layer_index = 0;
   for (LayerVector &layer : layers_) {
     auto const star_speed{star_speed_per_layer(layer_index)};
-    for (LayersVector::size_type i{0}; i < layer.size(); ++i) {
+    for (LayersVector::size_type i{0}; i < active_[layer_index]; ++i) {
       layer[i] = layer[i] + std::chrono::duration_cast<DoubleUpdateDiff>(d).count() * sg::DoubleVector{0.0, star_speed};
       if (layer[i].y() > game_size.y())
-        layer[i] = random_top_position(layer_index - 1);
+        layer[i] = random_top_position(layer_index);
     }
     layer_index++;
   }
@@ -54,16 +64,17 @@ void sg::Starfield::update(IntUpdateDiff const &d) {
 
 sg::RenderObjectList sg::Starfield::draw() {
   sg::RenderObjectList result;
-  result.reserve(std::accumulate(layers_.begin(),
-                                 layers_.end(),
+  result.reserve(std::accumulate(active_.begin(),
+                                 active_.end(),
                                  RenderObjectList::size_type{0},
-                                 [](RenderObjectList::size_type const n, LayerVector const &a) {
-                                   return n + a.size();
+                                 [](RenderObjectList::size_type const n, LayerVector::size_type const a) {
+                                   return n + a;
                                  }));
   LayersVector::size_type layer_index{layers_.size() - 1};
   for (LayersVector::const_reverse_iterator layer_it{layers_.crbegin()}; layer_it != layers_.crend(); ++layer_it) {
     auto const star_size{star_size_per_layer(layer_index)};
-    for (sg::DoubleVector const &pos : (*layer_it)) {
+    for (LayerVector::size_type i{0}; i < active_[layer_index]; ++i) {
+      sg::DoubleVector const &pos{(*layer_it)[i]};
       sg::IntRectangle const star_rect{sg::IntRectangle::from_pos_and_size(sg::rounding_cast<int>(pos), star_size)};
       result.push_back(Image{star_rect, main_atlas_path, star_path});
     }
@@ -72,3 +83,14 @@ sg::RenderObjectList sg::Starfield::draw() {
   return result;
 }
 
+
+void sg::Starfield::density(std::array<double, 3> const &fractions) {
+  for (LayersVector::size_type layer_index{0}; layer_index < layers_.size(); ++layer_index) {
+    auto const total{static_cast<double>(layers_[layer_index].size())};
+    active_[layer_index] = static_cast<LayerVector::size_type>(std::clamp(fractions[layer_index], 0.0, 1.0) * total);
+  }
+}
+
+void sg::Starfield::update_step(IntUpdateDiff const &step) {
+  step_ = step;
+}
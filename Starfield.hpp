@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include "SDL.hpp"
 #include "types.hpp"
@@ -18,10 +19,18 @@ public:
     explicit Starfield(RandomEngine &);
     void update(IntUpdateDiff const &);
     RenderObjectList draw();
+    // Only this fraction of each layer's stars is moved and drawn, nearest
+    // layer first.
+    void density(std::array<double, 3> const &);
+    // Moves the stars at most once per step.
+    void update_step(IntUpdateDiff const &);
 private:
     RandomEngine &random_engine_;
     std::uniform_real_distribution<double> distribution_x;
     std::uniform_real_distribution<double> distribution_y;
     LayersVector layers_;
+    std::array<LayerVector::size_type, 3> active_;
+    IntUpdateDiff step_;
+    IntUpdateDiff pending_;
 };
 }
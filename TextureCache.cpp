@@ -0,0 +1,127 @@
+#include "TextureCache.hpp"
+#include <future>
+
+namespace {
+sg::TextureCache::ByteCount texture_bytes(sg::SDLTexture const &t) {
+  auto const bytes_per_pixel{SDL_BYTESPERPIXEL(t.format())};
+  // Compressed/planar formats report 0 here; assume 32 bit like SDL's fallback.
+  return static_cast<sg::TextureCache::ByteCount>(t.size().x()) *
+         static_cast<sg::TextureCache::ByteCount>(t.size().y()) *
+         (bytes_per_pixel == 0 ? 4u : bytes_per_pixel);
+}
+}
+
+sg::TextureCache::TextureCache(sg::SDLImageContext &_image_context,
+                               sg::SDLRenderer &_renderer,
+                               std::optional<ByteCount> const _budget)
+        : image_context_{_image_context},
+          renderer_{_renderer},
+          budget_{_budget},
+          textures_{},
+          usage_{},
+          resident_bytes_{0},
+          hits_{0},
+          misses_{0},
+          evictions_{0} {}
+
+sg::SDLTexture &sg::TextureCache::get_texture(std::filesystem::path const &p) {
+  return load(p).texture;
+}
+
+sg::SDLTexture &sg::TextureCache::pin(std::filesystem::path const &p) {
+  Entry &e{load(p)};
+  e.pins++;
+  return e.texture;
+}
+
+void sg::TextureCache::unpin(std::filesystem::path const &p) {
+  auto const it{textures_.find(p)};
+  if (it == textures_.end() || it->second.pins == 0)
+    throw std::runtime_error{"texture \"" + p.string() + "\" is not pinned"};
+  it->second.pins--;
+  evict_to_budget();
+}
+
+bool sg::TextureCache::replace(std::filesystem::path const &p, SDLSurface &prepared) {
+  auto const it{textures_.find(p)};
+  if (it == textures_.end())
+    return false;
+  Entry &e{it->second};
+  e.texture = renderer_.upload_surface(prepared);
+  resident_bytes_ -= e.bytes;
+  e.bytes = texture_bytes(e.texture);
+  resident_bytes_ += e.bytes;
+  evict_to_budget();
+  return true;
+}
+
+void sg::TextureCache::budget(std::optional<ByteCount> const b) {
+  budget_ = b;
+  evict_to_budget();
+}
+
+double sg::TextureCache::hit_rate() const {
+  auto const total{hits_ + misses_};
+  return total == 0 ? 0.0 : static_cast<double>(hits_) / static_cast<double>(total);
+}
+
+sg::TextureCache::Entry &sg::TextureCache::load(std::filesystem::path const &p) {
+  TextureMap::iterator it{textures_.find(p)};
+  if (it != textures_.end()) {
+    hits_++;
+    usage_.splice(usage_.begin(), usage_, it->second.usage);
+    return it->second;
+  }
+  misses_++;
+  auto surface = image_context_.load_surface(p);
+  return insert(p, renderer_.create_texture(surface));
+}
+
+void sg::TextureCache::preload(std::vector<std::filesystem::path> const &paths) {
+  using PendingSurface = std::pair<std::filesystem::path, std::future<SDLSurface>>;
+  std::vector<PendingSurface> pending;
+  for (std::filesystem::path const &p : paths) {
+    if (textures_.find(p) != textures_.end())
+      continue;
+    pending.emplace_back(p, std::async(std::launch::async, [this, p]() {
+      SDLSurface loaded{image_context_.load_surface(p)};
+      return renderer_.prepare_surface(loaded);
+    }));
+  }
+  for (PendingSurface &p : pending) {
+    SDLSurface prepared{p.second.get()};
+    if (textures_.find(p.first) != textures_.end())
+      continue;
+    misses_++;
+    insert(p.first, renderer_.upload_surface(prepared));
+  }
+}
+
+sg::TextureCache::Entry &sg::TextureCache::insert(std::filesystem::path const &p, SDLTexture texture) {
+  auto const bytes{texture_bytes(texture)};
+  usage_.push_front(p);
+  Entry &result{textures_.insert(TextureMap::value_type{p, Entry{std::move(texture), bytes, 0, usage_.begin()}})
+                        .first->second};
+  resident_bytes_ += bytes;
+  evict_to_budget();
+  return result;
+}
+
+void sg::TextureCache::evict_to_budget() {
+  if (!budget_.has_value() || usage_.empty())
+    return;
+  // Never evict the most recently used texture; it is the one the caller is
+  // about to use.
+  auto it{usage_.end()};
+  --it;
+  while (resident_bytes_ > budget_.value() && it != usage_.begin()) {
+    auto const entry{textures_.find(*it)};
+    auto const current{it--};
+    if (entry->second.pins > 0)
+      continue;
+    resident_bytes_ -= entry->second.bytes;
+    evictions_++;
+    textures_.erase(entry);
+    usage_.erase(current);
+  }
+}
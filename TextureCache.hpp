@@ -1,35 +1,95 @@
 #pragma once
 
 #include <map>
+#include <list>
+#include <cstdint>
+#include <optional>
+#include <vector>
 #include <filesystem>
 #include "SDL.hpp"
 #include "util.hpp"
+#include "memory_tracking.hpp"
 
 namespace sg {
+// Keeps loaded textures resident up to a byte budget. Unpinned textures are
+// evicted least-recently-used first, so a reference returned by get_texture
+// is only guaranteed to survive until the next call that loads a texture.
+// Pinned textures (atlases referenced every frame) are never evicted.
 class TextureCache {
-private:
-  using TextureMap = std::map<std::filesystem::path, sg::SDLTexture>;
-
 public:
-  TextureCache(sg::SDLImageContext &image_context, sg::SDLRenderer &renderer)
-          : image_context_{image_context}, renderer_{renderer} {}
-
-  sg::SDLTexture &get_texture(std::filesystem::path const &p) {
-    TextureMap::iterator it{textures_.find(p)};
-    if (it != textures_.end()) {
-      return it->second;
-    }
-    auto surface = image_context_.load_surface(p);
-    return textures_.insert(TextureMap::value_type{p, renderer_.create_texture(surface)}).first->second;
-  }
+  using ByteCount = std::size_t;
+  using Counter = std::uint64_t;
+
+  TextureCache(sg::SDLImageContext &, sg::SDLRenderer &, std::optional<ByteCount> budget = std::nullopt);
+
+  sg::SDLTexture &get_texture(std::filesystem::path const &);
+
+  sg::SDLTexture &pin(std::filesystem::path const &);
+
+  // Decodes and converts the images on worker threads, uploads them on the
+  // calling one.
+  void preload(std::vector<std::filesystem::path> const &);
+
+  void unpin(std::filesystem::path const &);
+
+  // Swaps a resident texture for one uploaded from a prepared surface,
+  // keeping references to it valid. Returns false if it isn't resident.
+  bool replace(std::filesystem::path const &, SDLSurface &prepared);
+
+  // Loads the image into memory only, bypassing the cache.
+  sg::SDLSurface load_surface(std::filesystem::path const &p) { return image_context_.load_surface(p); }
+
+  void budget(std::optional<ByteCount>);
+
+  [[nodiscard]] std::optional<ByteCount> budget() const { return budget_; }
+
+  [[nodiscard]] ByteCount resident_bytes() const { return resident_bytes_; }
+
+  [[nodiscard]] std::size_t size() const { return textures_.size(); }
+
+  [[nodiscard]] Counter hits() const { return hits_; }
+
+  [[nodiscard]] Counter misses() const { return misses_; }
+
+  [[nodiscard]] Counter evictions() const { return evictions_; }
+
+  [[nodiscard]] double hit_rate() const;
 
   SG_NONCOPYABLE(TextureCache);
   SG_NONMOVEABLE(TextureCache);
 
 private:
+  template<typename T>
+  using Allocator = TaggedAllocator<T, MemoryTag::Textures>;
+  using UsageList = std::list<std::filesystem::path, Allocator<std::filesystem::path>>;
+
+  struct Entry {
+    sg::SDLTexture texture;
+    ByteCount bytes;
+    unsigned pins;
+    UsageList::iterator usage;
+  };
+
+  using TextureMap = std::map<std::filesystem::path,
+          Entry,
+          std::less<std::filesystem::path>,
+          Allocator<std::pair<std::filesystem::path const, Entry>>>;
+
   sg::SDLImageContext &image_context_;
   sg::SDLRenderer &renderer_;
+  std::optional<ByteCount> budget_;
   TextureMap textures_;
+  UsageList usage_;
+  ByteCount resident_bytes_;
+  Counter hits_;
+  Counter misses_;
+  Counter evictions_;
+
+  Entry &load(std::filesystem::path const &);
+
+  Entry &insert(std::filesystem::path const &, sg::SDLTexture);
+
+  void evict_to_budget();
 };
 }
 
@@ -0,0 +1,349 @@
+#include "TiledRasterizer.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+Uint32 const opaque_white{0xffffffff};
+
+// x / 255, rounded, for x <= 255 * 255
+Uint32 div255(Uint32 x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+Uint32 channel(Uint32 const p, int const shift) {
+  return (p >> shift) & 0xff;
+}
+
+Uint32 pack(Uint32 const a, Uint32 const r, Uint32 const g, Uint32 const b) {
+  return a << 24 | r << 16 | g << 8 | b;
+}
+
+Uint32 premultiplied(SDL_Color const &c) {
+  return pack(c.a, div255(c.r * c.a), div255(c.g * c.a), div255(c.b * c.a));
+}
+
+// src + dst * (1 - src alpha), both premultiplied
+Uint32 over(Uint32 const src, Uint32 const dst) {
+  Uint32 const inverse{255 - (src >> 24)};
+  if (inverse == 0)
+    return src;
+  Uint32 result{0};
+  for (int const shift : {0, 8, 16, 24})
+    result |= std::min(Uint32{255}, channel(src, shift) + div255(channel(dst, shift) * inverse)) << shift;
+  return result;
+}
+
+Uint32 modulate(Uint32 const p, Uint32 const mod) {
+  Uint32 const alpha_mod{mod >> 24};
+  return pack(div255(channel(p, 24) * alpha_mod),
+              div255(div255(channel(p, 16) * channel(mod, 16)) * alpha_mod),
+              div255(div255(channel(p, 8) * channel(mod, 8)) * alpha_mod),
+              div255(div255(channel(p, 0) * channel(mod, 0)) * alpha_mod));
+}
+
+#if defined(__AVX2__)
+__m256i div255(__m256i x) {
+  x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+// dst * (255 - src alpha) / 255 for one half of the pixels, 16 bits per channel
+__m256i scale_by_inverse_alpha(__m256i const src16, __m256i const dst16) {
+  __m256i const alpha{_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(src16, _MM_SHUFFLE(3, 3, 3, 3)),
+                                             _MM_SHUFFLE(3, 3, 3, 3))};
+  return div255(_mm256_mullo_epi16(dst16, _mm256_sub_epi16(_mm256_set1_epi16(255), alpha)));
+}
+
+__m256i over(__m256i const src, __m256i const dst) {
+  __m256i const zero{_mm256_setzero_si256()};
+  __m256i const lo{scale_by_inverse_alpha(_mm256_unpacklo_epi8(src, zero), _mm256_unpacklo_epi8(dst, zero))};
+  __m256i const hi{scale_by_inverse_alpha(_mm256_unpackhi_epi8(src, zero), _mm256_unpackhi_epi8(dst, zero))};
+  return _mm256_adds_epu8(src, _mm256_packus_epi16(lo, hi));
+}
+#elif defined(__SSE2__)
+__m128i div255(__m128i x) {
+  x = _mm_add_epi16(x, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// dst * (255 - src alpha) / 255 for one half of the pixels, 16 bits per channel
+__m128i scale_by_inverse_alpha(__m128i const src16, __m128i const dst16) {
+  __m128i const alpha{_mm_shufflehi_epi16(_mm_shufflelo_epi16(src16, _MM_SHUFFLE(3, 3, 3, 3)),
+                                          _MM_SHUFFLE(3, 3, 3, 3))};
+  return div255(_mm_mullo_epi16(dst16, _mm_sub_epi16(_mm_set1_epi16(255), alpha)));
+}
+
+__m128i over(__m128i const src, __m128i const dst) {
+  __m128i const zero{_mm_setzero_si128()};
+  __m128i const lo{scale_by_inverse_alpha(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero))};
+  __m128i const hi{scale_by_inverse_alpha(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero))};
+  return _mm_adds_epu8(src, _mm_packus_epi16(lo, hi));
+}
+#endif
+
+// Sprites are mostly fully transparent or fully opaque, so whole groups of
+// those skip the arithmetic.
+void over_span(Uint32 *const dst, Uint32 const *const src, int const n) {
+  int i{0};
+#if defined(__AVX2__)
+  __m256i const alpha_mask{_mm256_set1_epi32(static_cast<int>(0xff000000u))};
+  __m256i const zero{_mm256_setzero_si256()};
+  for (; i + 8 <= n; i += 8) {
+    __m256i const s{_mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i))};
+    __m256i const a{_mm256_and_si256(s, alpha_mask)};
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, zero)) == -1)
+      continue;
+    auto *const d{reinterpret_cast<__m256i *>(dst + i)};
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, alpha_mask)) == -1)
+      _mm256_storeu_si256(d, s);
+    else
+      _mm256_storeu_si256(d, over(s, _mm256_loadu_si256(d)));
+  }
+#elif defined(__SSE2__)
+  __m128i const alpha_mask{_mm_set1_epi32(static_cast<int>(0xff000000u))};
+  __m128i const zero{_mm_setzero_si128()};
+  for (; i + 4 <= n; i += 4) {
+    __m128i const s{_mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i))};
+    __m128i const a{_mm_and_si128(s, alpha_mask)};
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, zero)) == 0xffff)
+      continue;
+    auto *const d{reinterpret_cast<__m128i *>(dst + i)};
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, alpha_mask)) == 0xffff)
+      _mm_storeu_si128(d, s);
+    else
+      _mm_storeu_si128(d, over(s, _mm_loadu_si128(d)));
+  }
+#endif
+  for (; i < n; ++i)
+    if (src[i] >> 24 != 0)
+      dst[i] = over(src[i], dst[i]);
+}
+
+// `color` is premultiplied
+void fill_span(Uint32 *const dst, Uint32 const color, int const n) {
+  if (color >> 24 == 0xff) {
+    std::fill(dst, dst + n, color);
+    return;
+  }
+  int i{0};
+#if defined(__AVX2__)
+  __m256i const c{_mm256_set1_epi32(static_cast<int>(color))};
+  for (; i + 8 <= n; i += 8) {
+    auto *const d{reinterpret_cast<__m256i *>(dst + i)};
+    _mm256_storeu_si256(d, over(c, _mm256_loadu_si256(d)));
+  }
+#elif defined(__SSE2__)
+  __m128i const c{_mm_set1_epi32(static_cast<int>(color))};
+  for (; i + 4 <= n; i += 4) {
+    auto *const d{reinterpret_cast<__m128i *>(dst + i)};
+    _mm_storeu_si128(d, over(c, _mm_loadu_si128(d)));
+  }
+#endif
+  for (; i < n; ++i)
+    dst[i] = over(color, dst[i]);
+}
+
+sg::IntRectangle intersection(sg::IntRectangle const &a, sg::IntRectangle const &b) {
+  return sg::IntRectangle{std::max(a.left(), b.left()), std::min(a.right(), b.right()),
+                          std::max(a.top(), b.top()), std::min(a.bottom(), b.bottom())};
+}
+
+bool empty(sg::IntRectangle const &r) {
+  return r.w() <= 0 || r.h() <= 0;
+}
+
+// 16.16 fixed point source step when stretching `from` pixels over `to`,
+// the way SDL's nearest neighbour blitter steps through them
+std::int64_t source_step(int const from, int const to) {
+  return (static_cast<std::int64_t>(from) << 16) / to;
+}
+
+// Source offset of destination pixel `i`
+int source_offset(int const i, std::int64_t const step) {
+  return static_cast<int>((i * step + step / 2) >> 16);
+}
+
+sg::IntVector tile_counts(sg::IntVector const &size) {
+  return sg::IntVector{(size.x() + sg::TiledRasterizer::tile_size - 1) / sg::TiledRasterizer::tile_size,
+                       (size.y() + sg::TiledRasterizer::tile_size - 1) / sg::TiledRasterizer::tile_size};
+}
+}
+
+sg::TiledRasterizer::TiledRasterizer(IntVector const &_size, unsigned const _threads)
+        : size_{0, 0},
+          tiles_{0, 0},
+          pixels_{},
+          clear_color_{pack(0xff, 0, 0, 0)},
+          commands_{},
+          bins_{},
+          finished_{false},
+          next_tile_{0},
+          mutex_{},
+          start_{},
+          done_{},
+          generation_{0},
+          busy_{0},
+          stop_{false},
+          workers_{} {
+  resize(_size);
+  unsigned const threads{_threads != 0 ? _threads : std::max(1u, std::thread::hardware_concurrency())};
+  for (unsigned i{1}; i < threads; ++i)
+    workers_.emplace_back([this]() { work(); });
+}
+
+sg::TiledRasterizer::~TiledRasterizer() {
+  {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (std::thread &t : workers_)
+    t.join();
+}
+
+void sg::TiledRasterizer::resize(IntVector const &size) {
+  size_ = size;
+  tiles_ = tile_counts(size);
+  pixels_.assign(static_cast<std::size_t>(size.x()) * static_cast<std::size_t>(size.y()), clear_color_);
+  commands_.clear();
+  bins_.assign(static_cast<std::size_t>(tiles_.x()) * static_cast<std::size_t>(tiles_.y()), {});
+  finished_ = false;
+}
+
+void sg::TiledRasterizer::clear(SDL_Color const &c) {
+  clear_color_ = pack(c.a, c.r, c.g, c.b);
+  commands_.clear();
+  for (auto &b : bins_)
+    b.clear();
+  finished_ = false;
+}
+
+void sg::TiledRasterizer::copy(std::shared_ptr<RasterImage const> const &image,
+                               IntRectangle const &from,
+                               IntRectangle const &to,
+                               std::optional<SDL_Color> const &color_mod) {
+  // Sampling outside of the image isn't an option, unlike stretching a bit
+  IntRectangle const source{intersection(from, IntRectangle::from_size_at_origin(image->size))};
+  if (empty(source) || empty(to))
+    return;
+  Uint32 const mod{color_mod.has_value() ? pack(color_mod->a, color_mod->r, color_mod->g, color_mod->b)
+                                         : opaque_white};
+  bin(Command{image, source, to, mod});
+}
+
+void sg::TiledRasterizer::fill(IntRectangle const &r, SDL_Color const &c) {
+  if (c.a == 0)
+    return;
+  bin(Command{nullptr, r, r, premultiplied(c)});
+}
+
+void sg::TiledRasterizer::bin(Command c) {
+  IntRectangle const visible{intersection(c.to, IntRectangle::from_size_at_origin(size_))};
+  if (empty(visible))
+    return;
+  auto const index{static_cast<std::uint32_t>(commands_.size())};
+  commands_.push_back(std::move(c));
+  finished_ = false;
+  for (int ty{visible.top() / tile_size}; ty <= (visible.bottom() - 1) / tile_size; ++ty)
+    for (int tx{visible.left() / tile_size}; tx <= (visible.right() - 1) / tile_size; ++tx)
+      bins_[static_cast<std::size_t>(ty * tiles_.x() + tx)].push_back(index);
+}
+
+Uint32 const *sg::TiledRasterizer::finish() {
+  if (finished_)
+    return pixels_.data();
+  next_tile_ = 0;
+  {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    ++generation_;
+    busy_ = workers_.size();
+  }
+  start_.notify_all();
+  rasterize_tiles();
+  std::unique_lock<std::mutex> lock{mutex_};
+  done_.wait(lock, [this]() { return busy_ == 0; });
+  finished_ = true;
+  return pixels_.data();
+}
+
+void sg::TiledRasterizer::work() {
+  std::uint64_t seen{0};
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      start_.wait(lock, [this, &seen]() { return stop_ || generation_ != seen; });
+      if (stop_)
+        return;
+      seen = generation_;
+    }
+    rasterize_tiles();
+    {
+      std::lock_guard<std::mutex> const lock{mutex_};
+      --busy_;
+    }
+    done_.notify_one();
+  }
+}
+
+void sg::TiledRasterizer::rasterize_tiles() {
+  for (std::size_t tile{next_tile_++}; tile < bins_.size(); tile = next_tile_++)
+    rasterize(tile);
+}
+
+void sg::TiledRasterizer::rasterize(std::size_t const tile) {
+  int const tx{static_cast<int>(tile) % tiles_.x()};
+  int const ty{static_cast<int>(tile) / tiles_.x()};
+  IntRectangle const bounds{intersection(
+          IntRectangle::from_pos_and_size(IntVector{tx * tile_size, ty * tile_size}, IntVector{tile_size, tile_size}),
+          IntRectangle::from_size_at_origin(size_))};
+  auto const row = [this](int const y) { return pixels_.data() + static_cast<std::ptrdiff_t>(y) * size_.x(); };
+  for (int y{bounds.top()}; y < bounds.bottom(); ++y)
+    std::fill(row(y) + bounds.left(), row(y) + bounds.right(), clear_color_);
+
+  std::array<Uint32, tile_size> scratch{};
+  std::array<int, tile_size> columns{};
+  for (std::uint32_t const index : bins_[tile]) {
+    Command const &c{commands_[index]};
+    IntRectangle const r{intersection(c.to, bounds)};
+    int const w{r.w()};
+    if (!c.image) {
+      for (int y{r.top()}; y < r.bottom(); ++y)
+        fill_span(row(y) + r.left(), c.color, w);
+      continue;
+    }
+    RasterImage const &image{*c.image};
+    bool const stretched{!(c.from.size() == c.to.size())};
+    bool const modulated{c.color != opaque_white};
+    bool const blended{!image.opaque || c.color >> 24 != 0xff};
+    // Every row of a stretched copy reads the same source columns
+    auto const step_y{source_step(c.from.h(), c.to.h())};
+    if (stretched) {
+      auto const step_x{source_step(c.from.w(), c.to.w())};
+      for (int i{0}; i < w; ++i)
+        columns[static_cast<std::size_t>(i)] = source_offset(r.left() - c.to.left() + i, step_x);
+    }
+    for (int y{r.top()}; y < r.bottom(); ++y) {
+      int const sy{c.from.top() + (stretched ? source_offset(y - c.to.top(), step_y) : y - c.to.top())};
+      Uint32 const *const source_row{image.pixels.data() + static_cast<std::ptrdiff_t>(sy) * image.size.x() +
+                                     c.from.left()};
+      Uint32 const *src{source_row + (r.left() - c.to.left())};
+      if (stretched || modulated) {
+        for (int i{0}; i < w; ++i) {
+          Uint32 const p{stretched ? source_row[columns[static_cast<std::size_t>(i)]] : src[i]};
+          scratch[static_cast<std::size_t>(i)] = modulated ? modulate(p, c.color) : p;
+        }
+        src = scratch.data();
+      }
+      if (blended)
+        over_span(row(y) + r.left(), src, w);
+      else
+        std::memcpy(row(y) + r.left(), src, static_cast<std::size_t>(w) * sizeof(Uint32));
+    }
+  }
+}
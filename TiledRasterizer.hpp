@@ -0,0 +1,102 @@
+#pragma once
+
+#include <SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "math.hpp"
+#include "util.hpp"
+
+namespace sg {
+// A texture of the tiled backend: premultiplied ARGB8888 in main memory
+struct RasterImage {
+  std::vector<Uint32> pixels;
+  IntVector size;
+  // Can be copied without blending
+  bool opaque;
+};
+
+// Renders into an ARGB8888 framebuffer on the CPU. Draw commands are only
+// binned into square screen tiles as they come in; finish() then rasterizes
+// the tiles in parallel, each tile on one thread, so no two threads ever
+// write the same pixel.
+class TiledRasterizer {
+public:
+  static constexpr int tile_size{64};
+
+  // With 0 threads there's one per hardware thread, the caller's included.
+  explicit TiledRasterizer(IntVector const &_size, unsigned _threads = 0);
+
+  SG_NONCOPYABLE(TiledRasterizer);
+  SG_NONMOVEABLE(TiledRasterizer);
+
+  ~TiledRasterizer();
+
+  // Also drops the commands of the current frame
+  void resize(IntVector const &);
+
+  [[nodiscard]] IntVector size() const { return size_; }
+
+  [[nodiscard]] int pitch() const { return size_.x() * static_cast<int>(sizeof(Uint32)); }
+
+  [[nodiscard]] std::size_t threads() const { return workers_.size() + 1; }
+
+  // Starts a new frame, filled with `color` as is
+  void clear(SDL_Color const &);
+
+  // Nearest neighbour scaled like SDL_RenderCopy; the image is kept alive
+  // until the next clear. A color mod multiplies the premultiplied pixels.
+  void copy(std::shared_ptr<RasterImage const> const &,
+            IntRectangle const &from,
+            IntRectangle const &to,
+            std::optional<SDL_Color> const &color_mod);
+
+  // Blends like SDL_RenderFillRect with SDL_BLENDMODE_BLEND
+  void fill(IntRectangle const &, SDL_Color const &);
+
+  // Rasterizes the frame, unless nothing was drawn since the last call; the
+  // pixels stay valid until the next call.
+  Uint32 const *finish();
+
+private:
+  struct Command {
+    // Empty for fills
+    std::shared_ptr<RasterImage const> image;
+    IntRectangle from;
+    IntRectangle to;
+    // Premultiplied fill color, or the copy's color mod
+    Uint32 color;
+  };
+
+  IntVector size_;
+  IntVector tiles_;
+  std::vector<Uint32> pixels_;
+  Uint32 clear_color_;
+  std::vector<Command> commands_;
+  // Indices into commands_, per tile, in submission order
+  std::vector<std::vector<std::uint32_t>> bins_;
+  bool finished_;
+  std::atomic<std::size_t> next_tile_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  std::uint64_t generation_;
+  std::size_t busy_;
+  bool stop_;
+  std::vector<std::thread> workers_;
+
+  void bin(Command);
+
+  void work();
+
+  // Takes tiles until there are none left
+  void rasterize_tiles();
+
+  void rasterize(std::size_t tile);
+};
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace sg {
+struct TimerHandle {
+  std::uint32_t index{std::numeric_limits<std::uint32_t>::max()};
+  std::uint32_t generation{0};
+};
+
+// Hierarchical timing wheel over simulation time in milliseconds: four
+// levels of 64 slots, each slot of a level spanning a whole turn of the one
+// below. A timer goes into the finest level its distance fits and moves down
+// a level each time the level below wraps, so scheduling and cancelling are
+// O(1) and advancing costs a slot check per millisecond plus the timers that
+// fire or move. Timers further out than the wheel reaches (about 4.6 hours)
+// park in the coarsest level until they fit.
+//
+// Payloads are plain data so the owner can rebuild the wheel from its own
+// state, e.g. after restoring a snapshot. Timers due at the same time fire in
+// no particular order.
+template<typename Payload>
+class TimerWheel {
+  static_assert(std::is_trivially_copyable_v<Payload>, "timers are plain data");
+
+public:
+  using Time = std::chrono::milliseconds;
+
+  explicit TimerWheel(Time const &_now = Time{0}) : now_{_now.count()}, slots_{}, entries_{}, free_{}, size_{0} {
+    slots_.fill(nil);
+  }
+
+  [[nodiscard]] Time now() const { return Time{now_}; }
+
+  [[nodiscard]] std::size_t size() const { return size_; }
+
+  // Timers due at or before now() fire on the next advance().
+  TimerHandle schedule(Time const &due, Payload const &payload) {
+    std::uint32_t index;
+    if (!free_.empty()) {
+      index = free_.back();
+      free_.pop_back();
+    } else {
+      index = static_cast<std::uint32_t>(entries_.size());
+      entries_.push_back(Entry{});
+    }
+    Entry &e{entries_[index]};
+    e.payload = payload;
+    e.due = due.count();
+    e.live = true;
+    // This millisecond's slot has already fired
+    insert(index, now_ + 1);
+    ++size_;
+    return TimerHandle{index, e.generation};
+  }
+
+  // False if the timer already fired or was cancelled
+  bool cancel(TimerHandle const &handle) {
+    if (handle.index >= entries_.size())
+      return false;
+    Entry const &e{entries_[handle.index]};
+    if (!e.live || e.generation != handle.generation)
+      return false;
+    unlink(handle.index);
+    release(handle.index);
+    return true;
+  }
+
+  // Fires every timer due up to and including `to`, in order of due time.
+  // `fire` may schedule and cancel timers; ones due by `to` still fire.
+  template<typename F>
+  void advance(Time const &to, F const &fire) {
+    while (now_ < to.count()) {
+      ++now_;
+      // Every level that wrapped hands its next slot down, coarsest first
+      auto const tick{static_cast<std::uint64_t>(now_)};
+      for (std::size_t level{level_count - 1}; level > 0; --level)
+        if ((tick & ((std::uint64_t{1} << (slot_bits * level)) - 1)) == 0)
+          cascade(level, (tick >> (slot_bits * level)) & slot_mask);
+      std::uint32_t &head{slots_[tick & slot_mask]};
+      while (head != nil) {
+        std::uint32_t const index{head};
+        Payload const payload{entries_[index].payload};
+        unlink(index);
+        release(index);
+        fire(payload);
+      }
+    }
+  }
+
+  // Drops every timer and sets the time
+  void clear(Time const &_now) {
+    now_ = _now.count();
+    slots_.fill(nil);
+    free_.clear();
+    for (std::size_t i{entries_.size()}; i > 0; --i) {
+      Entry &e{entries_[i - 1]};
+      if (e.live) {
+        e.live = false;
+        ++e.generation;
+      }
+      free_.push_back(static_cast<std::uint32_t>(i - 1));
+    }
+    size_ = 0;
+  }
+
+private:
+  static constexpr std::size_t level_count{4};
+  static constexpr std::size_t slot_bits{6};
+  static constexpr std::uint64_t slot_mask{(std::uint64_t{1} << slot_bits) - 1};
+  static constexpr std::uint32_t nil{std::numeric_limits<std::uint32_t>::max()};
+  // Furthest distance a timer can be placed at
+  static constexpr std::int64_t reach{(std::int64_t{1} << (slot_bits * level_count)) - 1};
+
+  struct Entry {
+    Payload payload;
+    Time::rep due;
+    std::uint32_t previous;
+    std::uint32_t next;
+    std::uint32_t slot;
+    std::uint32_t generation;
+    bool live;
+  };
+
+  Time::rep now_;
+  std::array<std::uint32_t, level_count << slot_bits> slots_;
+  std::vector<Entry> entries_;
+  std::vector<std::uint32_t> free_;
+  std::size_t size_;
+
+  // Overdue timers go into the slot of `earliest`, far ones as far as it goes.
+  void insert(std::uint32_t const index, Time::rep const earliest) {
+    Entry &e{entries_[index]};
+    auto const at{static_cast<std::uint64_t>(
+            e.due < earliest ? earliest : e.due - now_ > reach ? now_ + reach : e.due)};
+    auto const distance{at - static_cast<std::uint64_t>(now_)};
+    std::size_t level{0};
+    while (level + 1 < level_count && distance >= (std::uint64_t{1} << (slot_bits * (level + 1))))
+      ++level;
+    e.slot = static_cast<std::uint32_t>((level << slot_bits) + ((at >> (slot_bits * level)) & slot_mask));
+    e.previous = nil;
+    e.next = slots_[e.slot];
+    if (e.next != nil)
+      entries_[e.next].previous = index;
+    slots_[e.slot] = index;
+  }
+
+  void unlink(std::uint32_t const index) {
+    Entry const &e{entries_[index]};
+    if (e.previous != nil)
+      entries_[e.previous].next = e.next;
+    else
+      slots_[e.slot] = e.next;
+    if (e.next != nil)
+      entries_[e.next].previous = e.previous;
+  }
+
+  void release(std::uint32_t const index) {
+    Entry &e{entries_[index]};
+    e.live = false;
+    ++e.generation;
+    free_.push_back(index);
+    --size_;
+  }
+
+  void cascade(std::size_t const level, std::uint64_t const slot) {
+    std::uint32_t &head{slots_[(level << slot_bits) + slot]};
+    std::uint32_t index{head};
+    head = nil;
+    while (index != nil) {
+      std::uint32_t const next{entries_[index].next};
+      insert(index, now_);
+      index = next;
+    }
+  }
+};
+}
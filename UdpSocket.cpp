@@ -0,0 +1,68 @@
+#include "UdpSocket.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+
+namespace {
+sockaddr_in loopback_address(std::uint16_t const port) {
+  sockaddr_in result{};
+  result.sin_family = AF_INET;
+  result.sin_port = htons(port);
+  result.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return result;
+}
+
+std::size_t const max_datagram_size{1500};
+}
+
+sg::UdpSocket::UdpSocket(std::uint16_t const _local_port, std::uint16_t const _remote_port)
+        : fd_{::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0)}, remote_port_{_remote_port} {
+  if (fd_ < 0)
+    throw std::runtime_error{std::string{"couldn't create socket: "} + std::strerror(errno)};
+  sockaddr_in const address{loopback_address(_local_port)};
+  if (::bind(fd_, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) != 0) {
+    auto const error{errno};
+    ::close(fd_);
+    throw std::runtime_error{"couldn't bind to port " + std::to_string(_local_port) + ": " + std::strerror(error)};
+  }
+}
+
+sg::UdpSocket::UdpSocket(UdpSocket &&o) noexcept: fd_{std::exchange(o.fd_, -1)}, remote_port_{o.remote_port_} {}
+
+sg::UdpSocket &sg::UdpSocket::operator=(UdpSocket &&o) noexcept {
+  std::swap(fd_, o.fd_);
+  std::swap(remote_port_, o.remote_port_);
+  return *this;
+}
+
+sg::UdpSocket::~UdpSocket() {
+  if (fd_ >= 0)
+    ::close(fd_);
+}
+
+void sg::UdpSocket::send(std::vector<std::uint8_t> const &datagram) const {
+  sockaddr_in const address{loopback_address(remote_port_)};
+  if (::sendto(fd_, datagram.data(), datagram.size(), 0, reinterpret_cast<sockaddr const *>(&address),
+               sizeof(address)) < 0
+      && errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNREFUSED)
+    throw std::runtime_error{std::string{"couldn't send datagram: "} + std::strerror(errno)};
+}
+
+std::optional<std::vector<std::uint8_t>> sg::UdpSocket::receive() const {
+  std::vector<std::uint8_t> result(max_datagram_size);
+  auto const size{::recv(fd_, result.data(), result.size(), 0)};
+  if (size < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNREFUSED)
+      return std::nullopt;
+    throw std::runtime_error{std::string{"couldn't receive datagram: "} + std::strerror(errno)};
+  }
+  result.resize(static_cast<std::size_t>(size));
+  return result;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "util.hpp"
+
+namespace sg {
+// Non-blocking UDP socket bound to a loopback port, talking to one peer on
+// another loopback port.
+class UdpSocket {
+public:
+  UdpSocket(std::uint16_t local_port, std::uint16_t remote_port);
+
+  SG_NONCOPYABLE(UdpSocket);
+
+  UdpSocket(UdpSocket &&) noexcept;
+
+  UdpSocket &operator=(UdpSocket &&) noexcept;
+
+  ~UdpSocket();
+
+  // Datagrams the peer isn't listening for yet are silently dropped.
+  void send(std::vector<std::uint8_t> const &) const;
+
+  // The next pending datagram, if any
+  [[nodiscard]] std::optional<std::vector<std::uint8_t>> receive() const;
+
+private:
+  int fd_;
+  std::uint16_t remote_port_;
+};
+}
@@ -0,0 +1,113 @@
+#include "AssetPack.hpp"
+#include "AtlasPacker.hpp"
+#include "SDL.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+// Usage: spacegame_atlas <output.png> <directory or file>...
+// Packs the PNGs into one image and writes the frames next to it (same name,
+// .json) in the format Atlas::from_descriptor reads. Frames are named after
+// the file name, so names must be unique across all inputs.
+
+namespace {
+int const padding{2};
+int const extrude{1};
+int const max_atlas_size{4096};
+
+void blit(SDL_Surface *from, SDL_Rect const &from_rect, SDL_Surface *to, SDL_Rect to_rect) {
+  if (SDL_BlitScaled(from, &from_rect, to, &to_rect) != 0)
+    throw std::runtime_error{"couldn't blit: " + std::string{SDL_GetError()}};
+}
+
+// Copies the sprite and repeats its outermost pixels `extrude` times around
+// it, so filtering at the frame edge never samples the neighbours.
+void draw_sprite(SDL_Surface *sprite, SDL_Surface *atlas, sg::IntRectangle const &frame) {
+  SDL_SetSurfaceBlendMode(sprite, SDL_BLENDMODE_NONE);
+  int const x{frame.left()};
+  int const y{frame.top()};
+  int const w{frame.w()};
+  int const h{frame.h()};
+  int const e{extrude};
+  blit(sprite, SDL_Rect{0, 0, w, h}, atlas, SDL_Rect{x, y, w, h});
+  if (e == 0)
+    return;
+  blit(sprite, SDL_Rect{0, 0, w, 1}, atlas, SDL_Rect{x, y - e, w, e});
+  blit(sprite, SDL_Rect{0, h - 1, w, 1}, atlas, SDL_Rect{x, y + h, w, e});
+  blit(sprite, SDL_Rect{0, 0, 1, h}, atlas, SDL_Rect{x - e, y, e, h});
+  blit(sprite, SDL_Rect{w - 1, 0, 1, h}, atlas, SDL_Rect{x + w, y, e, h});
+  blit(sprite, SDL_Rect{0, 0, 1, 1}, atlas, SDL_Rect{x - e, y - e, e, e});
+  blit(sprite, SDL_Rect{w - 1, 0, 1, 1}, atlas, SDL_Rect{x + w, y - e, e, e});
+  blit(sprite, SDL_Rect{0, h - 1, 1, 1}, atlas, SDL_Rect{x - e, y + h, e, e});
+  blit(sprite, SDL_Rect{w - 1, h - 1, 1, 1}, atlas, SDL_Rect{x + w, y + h, e, e});
+}
+
+nlohmann::json frame_json(sg::IntRectangle const &frame) {
+  return nlohmann::json{
+          {"frame", {{"x", frame.left()}, {"y", frame.top()}, {"w", frame.w()}, {"h", frame.h()}}},
+          {"rotated", false},
+          {"trimmed", false},
+          {"spriteSourceSize", {{"x", 0}, {"y", 0}, {"w", frame.w()}, {"h", frame.h()}}},
+          {"sourceSize", {{"w", frame.w()}, {"h", frame.h()}}},
+          {"pivot", {{"x", 0.5}, {"y", 0.5}}}};
+}
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " <output.png> <directory or file>...\n";
+    return 1;
+  }
+  std::vector<std::filesystem::path> files;
+  for (int i{2}; i < argc; ++i) {
+    std::filesystem::path const p{argv[i]};
+    if (!std::filesystem::is_directory(p)) {
+      files.push_back(p);
+      continue;
+    }
+    for (std::filesystem::directory_entry const &e : std::filesystem::recursive_directory_iterator{p})
+      if (e.is_regular_file() && e.path().extension() == ".png")
+        files.push_back(e.path());
+  }
+  std::sort(files.begin(), files.end());
+  std::set<std::string> names;
+  for (std::filesystem::path const &p : files)
+    if (!names.insert(p.filename().string()).second)
+      throw std::runtime_error{"duplicate sprite name " + p.filename().string()};
+
+  sg::AssetPack const loose_files;
+  sg::SDLImageContext image_context{loose_files};
+  std::vector<sg::SDLSurface> sprites;
+  std::vector<sg::IntVector> sizes;
+  for (std::filesystem::path const &p : files) {
+    sprites.push_back(image_context.load_surface(p));
+    sizes.emplace_back(sprites.back().surface()->w, sprites.back().surface()->h);
+  }
+  auto const packed{sg::pack_atlas(sizes, padding, extrude, max_atlas_size)};
+  if (!packed.has_value())
+    throw std::runtime_error{"sprites don't fit into " + std::to_string(max_atlas_size) + " pixels square"};
+
+  sg::SDLSurface atlas{SDL_CreateRGBSurfaceWithFormat(0, packed->size.x(), packed->size.y(), 32,
+                                                      SDL_PIXELFORMAT_RGBA32)};
+  if (atlas.surface() == nullptr)
+    throw std::runtime_error{"couldn't create atlas surface: " + std::string{SDL_GetError()}};
+  nlohmann::json frames = nlohmann::json::object();
+  for (std::size_t i{0}; i < files.size(); ++i) {
+    draw_sprite(sprites[i].surface(), atlas.surface(), packed->frames[i]);
+    frames[files[i].filename().string()] = frame_json(packed->frames[i]);
+  }
+  std::filesystem::path const output{argv[1]};
+  image_context.save_png(atlas, output);
+  nlohmann::json const description{
+          {"frames", frames},
+          {"meta", {{"app", "spacegame_atlas"},
+                    {"image", output.filename().string()},
+                    {"format", "RGBA8888"},
+                    {"size", {{"w", packed->size.x()}, {"h", packed->size.y()}}},
+                    {"scale", 1}}}};
+  std::ofstream{std::filesystem::path{output}.replace_extension(".json")} << description.dump(2) << "\n";
+  std::cout << "packed " << files.size() << " sprites into " << packed->size.x() << "x" << packed->size.y() << " "
+            << output.string() << "\n";
+}
@@ -0,0 +1,55 @@
+#include "batch_math.hpp"
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+std::uint32_t *put_bits(unsigned bits, std::uint32_t const base, std::uint32_t *result) {
+  while (bits != 0) {
+    *result++ = base + static_cast<std::uint32_t>(__builtin_ctz(bits));
+    bits &= bits - 1;
+  }
+  return result;
+}
+}
+
+std::size_t sg::intersecting(FloatRectangle const &r,
+                             float const *const left_edges,
+                             float const *const right_edges,
+                             float const *const top_edges,
+                             float const *const bottom_edges,
+                             std::size_t const n,
+                             std::uint32_t *const result) {
+  std::uint32_t *out{result};
+  std::size_t i{0};
+#if defined(__AVX__)
+  __m256 const left{_mm256_set1_ps(r.left())};
+  __m256 const right{_mm256_set1_ps(r.right())};
+  __m256 const top{_mm256_set1_ps(r.top())};
+  __m256 const bottom{_mm256_set1_ps(r.bottom())};
+  for (; i + 8 <= n; i += 8) {
+    __m256 const x{_mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(right_edges + i), left, _CMP_GE_OQ),
+                                 _mm256_cmp_ps(_mm256_loadu_ps(left_edges + i), right, _CMP_LE_OQ))};
+    __m256 const y{_mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(bottom_edges + i), top, _CMP_GE_OQ),
+                                 _mm256_cmp_ps(_mm256_loadu_ps(top_edges + i), bottom, _CMP_LE_OQ))};
+    out = put_bits(static_cast<unsigned>(_mm256_movemask_ps(_mm256_and_ps(x, y))), static_cast<std::uint32_t>(i), out);
+  }
+#elif defined(__SSE2__)
+  __m128 const left{_mm_set1_ps(r.left())};
+  __m128 const right{_mm_set1_ps(r.right())};
+  __m128 const top{_mm_set1_ps(r.top())};
+  __m128 const bottom{_mm_set1_ps(r.bottom())};
+  for (; i + 4 <= n; i += 4) {
+    __m128 const x{_mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(right_edges + i), left),
+                              _mm_cmple_ps(_mm_loadu_ps(left_edges + i), right))};
+    __m128 const y{_mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(bottom_edges + i), top),
+                              _mm_cmple_ps(_mm_loadu_ps(top_edges + i), bottom))};
+    out = put_bits(static_cast<unsigned>(_mm_movemask_ps(_mm_and_ps(x, y))), static_cast<std::uint32_t>(i), out);
+  }
+#endif
+  for (; i < n; ++i)
+    if (rect_intersect(r, FloatRectangle{left_edges[i], right_edges[i], top_edges[i], bottom_edges[i]}))
+      *out++ = static_cast<std::uint32_t>(i);
+  return static_cast<std::size_t>(out - result);
+}
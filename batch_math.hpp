@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "math.hpp"
+
+namespace sg {
+// Axis-aligned boxes stored one edge per array, so several boxes can be
+// tested in one SIMD instruction.
+template<typename Allocator = std::allocator<float>>
+class AabbBatch {
+public:
+  void push(FloatRectangle const &r) {
+    left_.push_back(r.left());
+    right_.push_back(r.right());
+    top_.push_back(r.top());
+    bottom_.push_back(r.bottom());
+  }
+
+  void clear() {
+    left_.clear();
+    right_.clear();
+    top_.clear();
+    bottom_.clear();
+  }
+
+  void reserve(std::size_t const n) {
+    left_.reserve(n);
+    right_.reserve(n);
+    top_.reserve(n);
+    bottom_.reserve(n);
+  }
+
+  [[nodiscard]] std::size_t size() const { return left_.size(); }
+
+  [[nodiscard]] FloatRectangle operator[](std::size_t const i) const {
+    return FloatRectangle{left_[i], right_[i], top_[i], bottom_[i]};
+  }
+
+  [[nodiscard]] float const *left() const { return left_.data(); }
+  [[nodiscard]] float const *right() const { return right_.data(); }
+  [[nodiscard]] float const *top() const { return top_.data(); }
+  [[nodiscard]] float const *bottom() const { return bottom_.data(); }
+
+private:
+  std::vector<float, Allocator> left_;
+  std::vector<float, Allocator> right_;
+  std::vector<float, Allocator> top_;
+  std::vector<float, Allocator> bottom_;
+};
+
+// Writes the indices of the `n` boxes intersecting `r` (touching counts,
+// like rect_intersect) to `result`, in ascending order, and returns how
+// many there are. `result` needs room for `n` indices.
+std::size_t intersecting(FloatRectangle const &r,
+                         float const *left,
+                         float const *right,
+                         float const *top,
+                         float const *bottom,
+                         std::size_t n,
+                         std::uint32_t *result);
+
+template<typename Allocator>
+std::size_t intersecting(FloatRectangle const &r, AabbBatch<Allocator> const &boxes, std::uint32_t *const result) {
+  return intersecting(r, boxes.left(), boxes.right(), boxes.top(), boxes.bottom(), boxes.size(), result);
+}
+}
@@ -0,0 +1,225 @@
+#include "SDL.hpp"
+#include "TextureCache.hpp"
+#include "Atlas.hpp"
+#include "constants.hpp"
+#include "Enemies.hpp"
+#include "TiledRasterizer.hpp"
+#include "types.hpp"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+
+// Measures sprite blit throughput of SDL's software renderer with surfaces
+// handed over as loaded versus converted to the native format up front, and
+// that of the tiled CPU backend. Before timing, the tiled backend's output
+// for a random scene is checked against a plain floating point blend; a
+// mismatch fails the run.
+
+namespace {
+std::size_t const frames{200};
+std::size_t const sprites_per_frame{2000};
+// What the tiled backend is meant to reach over SDL's software renderer
+double const tiled_target_speedup{3};
+std::size_t const reference_commands{3000};
+
+// Premultiplied ARGB8888, one double per channel, blue first
+struct Pixel {
+  std::array<double, 4> c;
+};
+
+Pixel unpack(Uint32 const p) {
+  return Pixel{{static_cast<double>(p & 0xff), static_cast<double>((p >> 8) & 0xff),
+                static_cast<double>((p >> 16) & 0xff), static_cast<double>(p >> 24)}};
+}
+
+Uint32 pack(Pixel const &p) {
+  Uint32 result{0};
+  for (unsigned i{0}; i < 4; ++i)
+    result |= static_cast<Uint32>(std::min(255.0, std::round(p.c[i]))) << (i * 8);
+  return result;
+}
+
+Uint32 over(Uint32 const src, Uint32 const dst) {
+  Pixel const s{unpack(src)};
+  Pixel const d{unpack(dst)};
+  Pixel result{};
+  for (unsigned i{0}; i < 4; ++i)
+    result.c[i] = s.c[i] + std::round(d.c[i] * (255.0 - s.c[3]) / 255.0);
+  return pack(result);
+}
+
+// SDL's nearest neighbour stepping, in 16.16 fixed point
+int source_offset(int const i, int const from, int const to) {
+  auto const step{(static_cast<std::int64_t>(from) << 16) / to};
+  return static_cast<int>((i * step + step / 2) >> 16);
+}
+
+// Pixels sprites are mostly made of, plus anything in between
+Uint32 random_pixel(sg::RandomEngine &random_engine, bool const opaque) {
+  std::uniform_int_distribution<int> kind{0, 2};
+  std::uniform_int_distribution<int> byte{0, 255};
+  int const k{kind(random_engine)};
+  double const a{opaque || k == 0 ? 255.0 : k == 1 ? 0.0 : static_cast<double>(byte(random_engine))};
+  Pixel p{{0, 0, 0, a}};
+  for (unsigned i{0}; i < 3; ++i)
+    p.c[i] = std::round(static_cast<double>(byte(random_engine)) * a / 255.0);
+  return pack(p);
+}
+
+// Number of pixels where the tiled backend differs from the reference
+std::size_t tiled_reference_mismatches() {
+  sg::IntVector const size{sg::game_size};
+  // Several workers even on small machines, so tiles get handed out
+  sg::TiledRasterizer tiled{size, 4};
+  sg::RandomEngine random_engine{1337};
+  std::uniform_int_distribution<int> byte{0, 255};
+  std::uniform_int_distribution<int> image_size{1, 96};
+  std::uniform_int_distribution<int> kind{0, 9};
+  auto const random_color = [&]() {
+    return SDL_Color{static_cast<Uint8>(byte(random_engine)), static_cast<Uint8>(byte(random_engine)),
+                     static_cast<Uint8>(byte(random_engine)), static_cast<Uint8>(byte(random_engine))};
+  };
+
+  std::vector<std::shared_ptr<sg::RasterImage const>> images;
+  for (int i{0}; i < 8; ++i) {
+    sg::IntVector const s{image_size(random_engine), image_size(random_engine)};
+    bool const opaque{i % 4 == 0};
+    std::vector<Uint32> pixels(static_cast<std::size_t>(s.x() * s.y()));
+    for (Uint32 &p : pixels)
+      p = random_pixel(random_engine, opaque);
+    images.push_back(std::make_shared<sg::RasterImage const>(sg::RasterImage{std::move(pixels), s, opaque}));
+  }
+
+  SDL_Color const clear{random_color()};
+  std::vector<Uint32> reference(static_cast<std::size_t>(size.x() * size.y()),
+                                Uint32{clear.a} << 24 | Uint32{clear.r} << 16 | Uint32{clear.g} << 8 | clear.b);
+  tiled.clear(clear);
+  std::uniform_int_distribution<int> x{-100, size.x()};
+  std::uniform_int_distribution<int> y{-100, size.y()};
+  std::uniform_int_distribution<int> extent{1, 150};
+  for (std::size_t n{0}; n < reference_commands; ++n) {
+    sg::IntRectangle const to{
+            sg::IntRectangle::from_pos_and_size(sg::IntVector{x(random_engine), y(random_engine)},
+                                                sg::IntVector{extent(random_engine), extent(random_engine)})};
+    auto const clipped = [&](int const px, int const py) {
+      return px < 0 || py < 0 || px >= size.x() || py >= size.y();
+    };
+    int const k{kind(random_engine)};
+    if (k == 0) {
+      SDL_Color const c{random_color()};
+      tiled.fill(to, c);
+      Pixel const color{{std::round(c.b * c.a / 255.0), std::round(c.g * c.a / 255.0),
+                         std::round(c.r * c.a / 255.0), static_cast<double>(c.a)}};
+      for (int py{to.top()}; py < to.bottom(); ++py)
+        for (int px{to.left()}; px < to.right(); ++px)
+          if (!clipped(px, py) && c.a != 0) {
+            Uint32 &d{reference[static_cast<std::size_t>(py * size.x() + px)]};
+            d = over(pack(color), d);
+          }
+      continue;
+    }
+    auto const &image{images[static_cast<std::size_t>(n % images.size())]};
+    std::uniform_int_distribution<int> fx{0, image->size.x() - 1};
+    std::uniform_int_distribution<int> fy{0, image->size.y() - 1};
+    int const left{fx(random_engine)};
+    int const top{fy(random_engine)};
+    std::uniform_int_distribution<int> fw{1, image->size.x() - left};
+    std::uniform_int_distribution<int> fh{1, image->size.y() - top};
+    // Unstretched copies half the time, as most sprites are drawn
+    sg::IntRectangle const from{k < 5 ? sg::IntRectangle::from_pos_and_size(sg::IntVector{left, top}, to.size())
+                                      : sg::IntRectangle::from_pos_and_size(sg::IntVector{left, top},
+                                                                            sg::IntVector{fw(random_engine),
+                                                                                          fh(random_engine)})};
+    if (from.right() > image->size.x() || from.bottom() > image->size.y())
+      continue;
+    std::optional<SDL_Color> const mod{k % 3 == 0 ? std::optional<SDL_Color>{random_color()} : std::nullopt};
+    tiled.copy(image, from, to, mod);
+    for (int py{to.top()}; py < to.bottom(); ++py)
+      for (int px{to.left()}; px < to.right(); ++px) {
+        if (clipped(px, py))
+          continue;
+        int const sx{from.left() + source_offset(px - to.left(), from.w(), to.w())};
+        int const sy{from.top() + source_offset(py - to.top(), from.h(), to.h())};
+        Pixel s{unpack(image->pixels[static_cast<std::size_t>(sy * image->size.x() + sx)])};
+        if (mod.has_value()) {
+          double const rgb_mod[]{static_cast<double>(mod->b), static_cast<double>(mod->g),
+                                 static_cast<double>(mod->r)};
+          for (unsigned i{0}; i < 3; ++i)
+            s.c[i] = std::round(std::round(s.c[i] * rgb_mod[i] / 255.0) * mod->a / 255.0);
+          s.c[3] = std::round(s.c[3] * mod->a / 255.0);
+        }
+        Uint32 &d{reference[static_cast<std::size_t>(py * size.x() + px)]};
+        d = over(pack(s), d);
+      }
+  }
+
+  Uint32 const *const result{tiled.finish()};
+  std::size_t mismatches{0};
+  for (std::size_t i{0}; i < reference.size(); ++i)
+    mismatches += result[i] != reference[i] ? 1 : 0;
+  return mismatches;
+}
+
+double blits_per_second(sg::AssetPack const &assets,
+                        sg::SDLImageContext &image_context,
+                        sg::SurfaceConversion const conversion,
+                        sg::RenderBackend const backend = sg::RenderBackend::Sdl) {
+  SDL_Surface *const target{
+          SDL_CreateRGBSurfaceWithFormat(0, sg::game_size.x(), sg::game_size.y(), 32, SDL_PIXELFORMAT_ARGB8888)};
+  if (target == nullptr)
+    throw std::runtime_error{"couldn't create target surface: " + std::string{SDL_GetError()}};
+  sg::SDLSurface target_surface{target};
+  SDL_Renderer *const software_renderer{SDL_CreateSoftwareRenderer(target_surface.surface())};
+  if (software_renderer == nullptr)
+    throw std::runtime_error{"couldn't create software renderer: " + std::string{SDL_GetError()}};
+  sg::SDLRenderer renderer{software_renderer, conversion, backend};
+  sg::TextureCache textures{image_context, renderer};
+  sg::AtlasCache atlases{assets, textures};
+  sg::Atlas &atlas{atlases.get(sg::main_atlas_path)};
+
+  sg::RandomEngine random_engine{1337};
+  std::uniform_int_distribution<int> x{0, sg::game_size.x()};
+  std::uniform_int_distribution<int> y{0, sg::game_size.y()};
+  sg::TexturePath const tiles[]{
+          sg::star_path, sg::enemy_texture(sg::EnemyType::AsteroidMedium), sg::ship_path, sg::laser_path};
+
+  auto const start{sg::Clock::now()};
+  for (std::size_t frame{0}; frame < frames; ++frame) {
+    renderer.clear();
+    for (std::size_t i{0}; i < sprites_per_frame; ++i)
+      atlas.render_tile(renderer,
+                        tiles[i % 4],
+                        sg::IntRectangle::from_pos_and_size(sg::IntVector{x(random_engine), y(random_engine)},
+                                                            sg::IntVector{42, 42}));
+    renderer.present();
+  }
+  std::chrono::duration<double> const elapsed{sg::Clock::now() - start};
+  return static_cast<double>(frames * sprites_per_frame) / elapsed.count();
+}
+}
+
+int main() {
+  auto const mismatches{tiled_reference_mismatches()};
+  std::cout << "tiled blending:     "
+            << (mismatches == 0 ? "matches reference" : std::to_string(mismatches) + " pixels differ from reference")
+            << "\n";
+  if (mismatches != 0)
+    return 1;
+
+  sg::AssetPack const assets;
+  sg::SDLImageContext image_context{assets};
+  auto const before{blits_per_second(assets, image_context, sg::SurfaceConversion::None)};
+  auto const after{blits_per_second(assets, image_context, sg::SurfaceConversion::NativePremultiplied)};
+  auto const tiled{
+          blits_per_second(assets, image_context, sg::SurfaceConversion::NativePremultiplied, sg::RenderBackend::Tiled)};
+  std::cout << "as loaded:          " << static_cast<long>(before) << " blits/s\n"
+            << "native:             " << static_cast<long>(after) << " blits/s\n"
+            << "speedup:            " << after / before << "x\n"
+            << "tiled:              " << static_cast<long>(tiled) << " blits/s\n"
+            << "tiled speedup:      " << tiled / after << "x over native, target " << tiled_target_speedup << "x "
+            << (tiled / after >= tiled_target_speedup ? "met" : "not met") << " with "
+            << std::thread::hardware_concurrency() << " hardware threads\n";
+}
@@ -0,0 +1,40 @@
+#include "GameState.hpp"
+#include "Console.hpp"
+#include "constants.hpp"
+#include <iostream>
+
+// Updates a wave of enemies of every registered type and reports the time
+// per enemy update.
+
+namespace {
+std::size_t const enemy_count{50000};
+std::size_t const ticks{100};
+sg::IntUpdateDiff const tick_length{10};
+}
+
+int main() {
+  sg::RandomEngine random_engine{1337};
+  sg::Console console;
+  std::uniform_real_distribution<double> x{0, static_cast<double>(sg::game_size.x())};
+  std::uniform_real_distribution<double> y{0, static_cast<double>(sg::game_size.y())};
+  sg::SpawnList spawns;
+  for (std::size_t i{0}; i < enemy_count; ++i)
+    spawns.push_back(sg::EnemySpawn{static_cast<sg::EnemyType>(i % sg::enemy_type_count),
+                                    std::chrono::milliseconds{0},
+                                    sg::DoubleVector{x(random_engine), y(random_engine)},
+                                    1});
+  sg::GameState gs{random_engine, console, std::move(spawns)};
+  sg::GameEventBus events;
+  // Spawns everything
+  gs.update(tick_length, events);
+
+  auto const start{sg::Clock::now()};
+  for (std::size_t i{0}; i < ticks; ++i) {
+    gs.update(tick_length, events);
+    events.discard();
+  }
+  std::chrono::duration<double, std::nano> const elapsed{sg::Clock::now() - start};
+  std::cout << gs.enemy_count() << " enemies of " << sg::enemy_type_count << " types, " << ticks << " ticks: "
+            << elapsed.count() / static_cast<double>(ticks) / 1e6 << " ms/tick, "
+            << elapsed.count() / static_cast<double>(ticks * gs.enemy_count()) << " ns/enemy\n";
+}
@@ -3,15 +3,19 @@
 #include <map>
 #include <list>
 #include <cstddef>
+#include <functional>
+#include <memory>
 #include <stdexcept>
 
 namespace sg {
 
-template<typename K, typename V>
+template<typename K, typename V, template<typename> class Allocator = std::allocator>
 class LRU {
 public:
   using key_value_pair_t = std::pair<K, V>;
-  using list_iterator_t = typename std::list<key_value_pair_t>::iterator;
+  using list_t = std::list<key_value_pair_t, Allocator<key_value_pair_t>>;
+  using list_iterator_t = typename list_t::iterator;
+  using map_t = std::map<K, list_iterator_t, std::less<K>, Allocator<std::pair<K const, list_iterator_t>>>;
 
   explicit LRU(std::size_t const max_size) : _max_size{max_size} {
   }
@@ -46,13 +50,18 @@ public:
     return _cache_items_map.find(key) != _cache_items_map.end();
   }
 
+  void clear() {
+    _cache_items_map.clear();
+    _cache_items_list.clear();
+  }
+
   [[nodiscard]] std::size_t size() const {
     return _cache_items_map.size();
   }
 
 private:
-  std::list<key_value_pair_t> _cache_items_list;
-  std::map<K, list_iterator_t> _cache_items_map;
+  list_t _cache_items_list;
+  map_t _cache_items_map;
   size_t _max_size;
 };
 }
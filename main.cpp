@@ -9,10 +9,24 @@
 #include "Atlas.hpp"
 #include "FontCache.hpp"
 #include "Console.hpp"
+#include "RenderQueue.hpp"
+#include "RenderObjectVisitor.hpp"
+#include "memory_tracking.hpp"
+#include "Snapshot.hpp"
+#include "Lockstep.hpp"
+#include "AssetReloader.hpp"
+#include "QualityGovernor.hpp"
+#include "MetricsExporter.hpp"
+#include "InputLatency.hpp"
+#include "RetainedLayer.hpp"
+#include "FrameCapture.hpp"
 #include <SDL.h>
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <optional>
+#include <string>
+#include <vector>
 
 namespace {
 
@@ -21,6 +35,11 @@ std::filesystem::path const pew_sound{sg::base_path / "Bonus" / "sfx_laser1.wav"
 std::filesystem::path const explosion_short_sound{sg::base_path / "explosion-short.wav"};
 std::filesystem::path const font_path{sg::base_path / "Bonus" / "kenvector_future_thin.ttf"};
 
+// Sounds lean towards the side of the screen they come from
+float pan_at(sg::DoubleVector const &position) {
+  return static_cast<float>(std::clamp(position.x() / sg::game_size.x() - 0.5, -0.5, 0.5));
+}
+
 std::optional<sg::IntVector> key_to_direction(SDL_Keycode const &k) {
   if (k == SDLK_a)
     return sg::IntVector{-1, 0};
@@ -33,50 +52,171 @@ std::optional<sg::IntVector> key_to_direction(SDL_Keycode const &k) {
   return std::nullopt;
 }
 
-struct RenderObjectVisitor {
-  sg::SDLRenderer &renderer;
-  sg::AtlasCache &atlas_cache;
-  sg::FontCache &font_cache;
-
-  RenderObjectVisitor(sg::SDLRenderer &renderer, sg::AtlasCache &atlas_cache, sg::FontCache &font_cache) : renderer{
-          renderer}, atlas_cache{atlas_cache}, font_cache{font_cache} {}
+std::string const usage{"usage: spacegame [--lockstep <player 0|1> <local port> <remote port>]"
+                        " [--metrics-socket <path>] [--metrics-port <port>] [--metrics-file <path>]"
+                        " [--synthetic-input <seconds>] [--renderer sdl|tiled]"
+                        " [--capture <directory>] [--capture-format png|qoi]"};
+// Between synthetic key events
+std::chrono::milliseconds const synthetic_input_interval{150};
 
-  void operator()(sg::Image const &image) const {
-    atlas_cache.get(image.atlas).render_tile(renderer, image.texture, image.rectangle);
-  }
-
-  void operator()(sg::Solid const &s) const {
-    renderer.fill_rect(s.rectangle, s.color);
-  }
+// What F1 shows and the exit report prints
+std::vector<std::string> diagnostics(sg::MemoryReport const &memory,
+                                     sg::QualityGovernor const &quality,
+                                     sg::InputLatency const &latency,
+                                     sg::SoundCache const &sounds,
+                                     std::optional<sg::FrameCapture> const &capture,
+                                     std::optional<sg::LockstepSession> const &lockstep) {
+  std::vector<std::string> result;
+  for (std::string const &line : sg::format_memory_report(memory))
+    result.push_back("memory " + line);
+  result.push_back(sg::format_quality(quality));
+  for (std::string const &line : sg::format_input_latency(latency))
+    result.push_back(line);
+  result.push_back("audio: " + std::to_string(sounds.sounds_played()) + " sounds played, " +
+                   std::to_string(sounds.mixer().active_voices()) + " voices playing, " +
+                   std::to_string(sounds.mixer().stolen_voices()) + " stolen");
+  if (capture.has_value())
+    result.push_back(sg::format_capture(capture.value()));
+  if (lockstep.has_value())
+    result.push_back(sg::format_lockstep_stats(lockstep->stats(), lockstep->input_delay()));
+  return result;
+}
 
-  void operator()(sg::Text const &t) const {
-    font_cache.copy_text(t.font, t.text, t.color, t.position);
-  }
+struct Arguments {
+  std::optional<sg::LockstepSession> lockstep;
+  sg::MetricsConfig metrics;
+  // Plays by itself for this long, then quits
+  std::optional<std::chrono::seconds> synthetic_input;
+  sg::RenderBackend renderer;
+  sg::CaptureConfig capture;
 };
 
-
+Arguments parse_arguments(int const argc, char *argv[]) {
+  Arguments result{};
+  std::vector<std::string> const args(argv + 1, argv + argc);
+  for (std::size_t i{0}; i < args.size(); ++i) {
+    auto const values = [&args, &i](std::size_t const count) {
+      if (i + count >= args.size())
+        throw std::runtime_error{usage};
+      std::vector<std::string> taken(args.begin() + static_cast<std::ptrdiff_t>(i + 1),
+                                     args.begin() + static_cast<std::ptrdiff_t>(i + 1 + count));
+      i += count;
+      return taken;
+    };
+    if (args[i] == "--lockstep") {
+      auto const v{values(3)};
+      auto const player{std::stoul(v[0])};
+      if (player > 1)
+        throw std::runtime_error{"player must be 0 or 1"};
+      result.lockstep.emplace(sg::UdpSocket{static_cast<std::uint16_t>(std::stoul(v[1])),
+                                            static_cast<std::uint16_t>(std::stoul(v[2]))},
+                              player,
+                              sg::lockstep_input_delay);
+    } else if (args[i] == "--metrics-socket") {
+      result.metrics.unix_socket = values(1)[0];
+    } else if (args[i] == "--metrics-port") {
+      result.metrics.http_port = static_cast<std::uint16_t>(std::stoul(values(1)[0]));
+    } else if (args[i] == "--metrics-file") {
+      result.metrics.dump_path = values(1)[0];
+    } else if (args[i] == "--synthetic-input") {
+      result.synthetic_input = std::chrono::seconds{std::stoul(values(1)[0])};
+    } else if (args[i] == "--renderer") {
+      auto const backend{values(1)[0]};
+      if (backend == "sdl")
+        result.renderer = sg::RenderBackend::Sdl;
+      else if (backend == "tiled")
+        result.renderer = sg::RenderBackend::Tiled;
+      else
+        throw std::runtime_error{usage};
+    } else if (args[i] == "--capture") {
+      result.capture.directory = values(1)[0];
+    } else if (args[i] == "--capture-format") {
+      auto const format{values(1)[0]};
+      if (format == "png")
+        result.capture.format = sg::CaptureFormat::Png;
+      else if (format == "qoi")
+        result.capture.format = sg::CaptureFormat::Qoi;
+      else
+        throw std::runtime_error{usage};
+    } else {
+      throw std::runtime_error{usage};
+    }
+  }
+  return result;
+}
 } // namespace
 
-int main() {
+int main(int argc, char *argv[]) {
+  Arguments arguments{parse_arguments(argc, argv)};
+  std::optional<sg::LockstepSession> &lockstep{arguments.lockstep};
   sg::Console console{};
+  sg::AssetPack const assets{std::filesystem::exists(sg::asset_pack_path) ? sg::AssetPack::map(sg::asset_pack_path)
+                                                                          : sg::AssetPack{}};
+  if (assets.size() > 0)
+    console.add_line("using asset pack with " + std::to_string(assets.size()) + " assets", true);
   sg::SDLContext context;
-  sg::SDLMixerContext mixer_context{context};
-  sg::SDLImageContext image_context;
+  sg::SDLMixerContext mixer_context{context, assets};
+  sg::SDLImageContext image_context{assets};
   sg::SDLWindow window{context.create_window(sg::game_size)};
-  sg::SDLTTFContext ttfcontext;
+  sg::SDLTTFContext ttfcontext{assets};
   sg::SDLTTFFont main_font{ttfcontext.open_font(font_path, 15)};
-  sg::SDLRenderer renderer{window.create_renderer(sg::game_size)};
+  sg::SDLRenderer renderer{window.create_renderer(sg::game_size, arguments.renderer)};
   sg::RandomEngine random_engine;
-  sg::GameState gs{random_engine, console};
-  sg::TextureCache texture_cache{image_context, renderer};
-  sg::AtlasCache atlas_cache{texture_cache};
+  // Kept apart from the star field's so both lockstep peers draw the same numbers
+  sg::RandomEngine game_random_engine;
+  sg::GameState gs{game_random_engine, console, lockstep.has_value() ? std::size_t{2} : std::size_t{1}};
+  sg::PlayerInput local_input{sg::IntVector{0, 0}, false};
+  sg::IntUpdateDiff lockstep_time{0};
+  sg::IntUpdateDiff rewind_time{0};
+  sg::TextureCache texture_cache{image_context, renderer, sg::texture_memory_budget};
+  texture_cache.preload({sg::main_atlas_path.path, sg::explosion_animation.path});
+  sg::AtlasCache atlas_cache{assets, texture_cache};
+  gs.load_collision_masks(atlas_cache.get(sg::main_atlas_path));
   sg::FontCache font_cache{ttfcontext, renderer};
   //Animation explosion_animation{texture_cache.get_texture(explosion_path), explosion_tile_size};
   sg::SoundCache sound_cache{mixer_context};
+  std::optional<sg::AssetReloader> reloader;
+  if (assets.size() == 0)
+    reloader.emplace(sg::base_path, assets, image_context, renderer, mixer_context);
   sg::Starfield star_field{random_engine};
+  sg::RenderQueue render_queue;
+  sg::RenderObjectVisitor const visitor{renderer, atlas_cache, font_cache};
+  sg::RetainedLayer hud_layer{renderer, sg::hud_size};
+  sg::RetainedLayer console_layer{renderer, sg::IntVector{sg::game_size.x(), sg::game_size.y() / 2}};
+  sg::SnapshotHistory history{static_cast<std::size_t>(sg::rewind_history / sg::rewind_interval)};
+  sg::QualityGovernor quality{sg::frame_budget};
+  sg::GameEventBus game_events;
+  game_events.subscribe<sg::PlayerShot>([&sound_cache](sg::PlayerShot const &e) {
+    sound_cache.play_chunk(pew_sound, 1.0f, pan_at(e.position));
+  });
+  game_events.subscribe<sg::AsteroidDestroyed>([&sound_cache](sg::AsteroidDestroyed const &e) {
+    sound_cache.play_chunk(explosion_short_sound, 1.0f, pan_at(e.position));
+  });
+  sg::InputLatency latency;
+  // Ticks run outside of lockstep
+  sg::InputLatency::TickId game_ticks{0};
+  std::optional<sg::SyntheticInput> synthetic_input;
+  if (arguments.synthetic_input.has_value())
+    synthetic_input.emplace(context, synthetic_input_interval);
+  std::uint64_t asteroids_destroyed{0};
+  std::uint64_t points_scored{0};
+  game_events.subscribe<sg::AsteroidDestroyed>([&asteroids_destroyed, &points_scored](sg::AsteroidDestroyed const &e) {
+    asteroids_destroyed++;
+    points_scored += static_cast<std::uint64_t>(e.score_delta);
+  });
+  std::optional<sg::MetricsExporter> metrics;
+  if (arguments.metrics.enabled())
+    metrics.emplace(arguments.metrics);
+  std::optional<sg::FrameCapture> capture;
+  if (arguments.capture.enabled())
+    capture.emplace(image_context, arguments.capture);
+  std::size_t frame_count{0};
+  std::size_t texture_switches{0};
+  sg::MemoryReport memory{sg::end_memory_frame()};
   std::cout << "game start\n";
   mixer_context.play_music(background_music);
   auto last_frame = sg::Clock::now();
+  auto const start_time{last_frame};
   auto const target_fps = std::chrono::milliseconds{10};
   bool done{false};
   while (!done) {
@@ -85,11 +225,32 @@ int main() {
     auto const int_time_delta{std::chrono::duration_cast<sg::IntUpdateDiff >(time_delta)};
     auto const wait_time{std::chrono::duration_cast<std::chrono::milliseconds>(target_fps - time_delta)};
     last_frame = this_frame;
+    if (reloader.has_value()) {
+      auto const reloaded{reloader->apply(texture_cache, atlas_cache, font_cache, sound_cache)};
+      for (std::string const &line : reloaded)
+        console.add_line(line, true);
+      if (!reloaded.empty()) {
+        gs.load_collision_masks(atlas_cache.get(sg::main_atlas_path));
+        hud_layer.invalidate();
+        console_layer.invalidate();
+      }
+    }
+    if (synthetic_input.has_value()) {
+      if (this_frame - start_time >= arguments.synthetic_input.value())
+        done = true;
+      synthetic_input->update();
+    }
+    sg::InputLatency::TickId const input_tick{lockstep.has_value() ? lockstep->next_input_tick() : game_ticks};
     for (SDL_Event const &e : context.wait_event(wait_time)) {
       if (e.type == SDL_QUIT) {
         done = true;
         break;
       }
+      // Some backends drop render target contents, e.g. on resize
+      if (e.type == SDL_RENDER_TARGETS_RESET) {
+        hud_layer.invalidate();
+        console_layer.invalidate();
+      }
 
       if (e.type == SDL_KEYDOWN && e.key.repeat == 0) {
         if (e.key.keysym.sym == SDLK_ESCAPE) {
@@ -98,39 +259,101 @@ int main() {
         }
         if (e.key.keysym.sym == SDLK_BACKQUOTE)
           console.toggle();
+        if (e.key.keysym.sym == SDLK_F1)
+          for (std::string const &line : diagnostics(memory, quality, latency, sound_cache, capture, lockstep))
+            console.add_line(line, true);
+        if (e.key.keysym.sym == SDLK_F2 && !lockstep.has_value() && history.size() > 0) {
+          gs.restore(history.rewind(static_cast<std::size_t>(sg::rewind_distance / sg::rewind_interval)));
+          // The keys held back then aren't the ones held now
+          gs.set_player_input(local_input);
+        }
         if (e.key.keysym.sym == SDLK_SPACE)
-          gs.player_shooting(true);
+          local_input.shooting = true;
         auto const direction = key_to_direction(e.key.keysym.sym);
         if (direction.has_value())
-          gs.add_player_v(direction.value());
+          local_input.direction += direction.value();
+        if (e.key.keysym.sym == SDLK_SPACE || direction.has_value())
+          latency.input(e.key.timestamp, input_tick);
       } else if (e.type == SDL_KEYUP && e.key.repeat == 0) {
         if (e.key.keysym.sym == SDLK_SPACE)
-          gs.player_shooting(false);
+          local_input.shooting = false;
         auto const direction = key_to_direction(e.key.keysym.sym);
         if (direction.has_value())
-          gs.add_player_v(-direction.value());
+          local_input.direction += -direction.value();
+        if (e.key.keysym.sym == SDLK_SPACE || direction.has_value())
+          latency.input(e.key.timestamp, input_tick);
       }
     }
 
-    for (sg::GameEvent const &ge : gs.update(int_time_delta)) {
-      switch (ge) {
-        case sg::GameEvent::PlayerShot:
-          sound_cache.play_chunk(pew_sound);
-          break;
-        case sg::GameEvent::AsteroidDestroyed:
-          sound_cache.play_chunk(explosion_short_sound);
-          break;
+    // Waiting for events isn't work the governor can do anything about
+    auto const work_start{sg::Clock::now()};
+    if (lockstep.has_value()) {
+      // Fixed ticks; time isn't banked while waiting on the peer
+      lockstep_time = std::min(lockstep_time + int_time_delta, sg::lockstep_tick * sg::lockstep_max_prediction);
+      while (lockstep_time >= sg::lockstep_tick && lockstep->advance(gs, local_input, game_events))
+        lockstep_time -= sg::lockstep_tick;
+      latency.simulated(lockstep->tick());
+    } else {
+      gs.set_player_input(local_input);
+      gs.update(int_time_delta, game_events);
+      // A long frame fills every interval it spanned with the same state
+      rewind_time = std::min(rewind_time + int_time_delta, sg::IntUpdateDiff{sg::rewind_history});
+      if (rewind_time >= sg::rewind_interval) {
+        sg::Snapshot const snapshot{gs.snapshot()};
+        for (; rewind_time >= sg::rewind_interval; rewind_time -= sg::rewind_interval)
+          history.push(snapshot);
       }
+      latency.simulated(++game_ticks);
     }
+    auto const tick_time{sg::Clock::now() - work_start};
+    game_events.dispatch();
     star_field.update(int_time_delta);
 
+    hud_layer.update(static_cast<sg::RetainedLayer::Revision>(gs.score()), [&gs]() { return gs.draw_hud(); }, visitor);
+    console_layer.update(console.revision(), [&console]() { return console.draw(); }, visitor);
     renderer.clear();
-    for (auto const &rob : star_field.draw())
-      std::visit(RenderObjectVisitor(renderer, atlas_cache, font_cache), rob);
-    for (const auto &rob : gs.draw())
-      std::visit(RenderObjectVisitor(renderer, atlas_cache, font_cache), rob);
-    for (const auto &rob : console.draw())
-      std::visit(RenderObjectVisitor(renderer, atlas_cache, font_cache), rob);
+    render_queue.push(sg::RenderLayer::Background, star_field.draw());
+    render_queue.push(sg::RenderLayer::Sprites, gs.draw());
+    render_queue.push(sg::RenderLayer::Effects, gs.draw_effects(quality.settings().particle_cap));
+    render_queue.flush(visitor);
+    hud_layer.composite(visitor);
+    console_layer.composite(visitor);
+    if (capture.has_value())
+      capture->capture(renderer);
     renderer.present();
+    latency.presented(SDL_GetTicks());
+    if (quality.frame(sg::Clock::now() - work_start)) {
+      sg::QualitySettings const &settings{quality.settings()};
+      star_field.density(settings.star_density);
+      star_field.update_step(settings.background_step);
+      renderer.render_scale(settings.render_scale);
+      console.add_line(sg::format_quality(quality), true);
+    }
+    if (metrics.has_value())
+      metrics->record(sg::FrameMetrics{time_delta,
+                                       tick_time,
+                                       static_cast<std::uint32_t>(gs.projectile_count()),
+                                       static_cast<std::uint32_t>(gs.enemy_count()),
+                                       static_cast<std::uint32_t>(gs.particle_count()),
+                                       texture_cache.hits(),
+                                       texture_cache.misses(),
+                                       font_cache.hits(),
+                                       font_cache.misses(),
+                                       sound_cache.sounds_played(),
+                                       sound_cache.mixer().stolen_voices(),
+                                       asteroids_destroyed,
+                                       points_scored});
+    frame_count++;
+    texture_switches += render_queue.texture_switches();
+    memory = sg::end_memory_frame();
   }
+  if (capture.has_value())
+    capture->flush();
+  for (std::string const &line : diagnostics(memory, quality, latency, sound_cache, capture, lockstep))
+    std::cout << line << "\n";
+  if (frame_count > 0)
+    std::cout << "texture switches per frame: "
+              << static_cast<double>(texture_switches) / static_cast<double>(frame_count) << "\n"
+              << "UI layer redraws: hud " << hud_layer.redraws() << ", console " << console_layer.redraws()
+              << " in " << frame_count << " frames\n";
 }
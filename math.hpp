@@ -1,27 +1,31 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <optional>
 #include <ostream>
+#include <utility>
 
 namespace sg {
 template <typename T>
 class Vector {
 public:
-  Vector(T const &_x, T const &_y) : _x(_x), _y(_y) {}
+  constexpr Vector(T const &_x, T const &_y) : _x(_x), _y(_y) {}
 
-  T const &x() const { return _x; }
+  constexpr T const &x() const { return _x; }
 
-  T const &y() const { return _y; }
+  constexpr T const &y() const { return _y; }
 
-  Vector<T> operator-() const { return Vector(-_x, -_y); }
+  constexpr Vector<T> operator-() const { return Vector(-_x, -_y); }
 
-  Vector<T> &operator+=(Vector<T> const &b) {
+  constexpr Vector<T> &operator+=(Vector<T> const &b) {
     _x += b._x;
     _y += b._y;
     return *this;
   }
 
-  bool operator==(Vector<T> const &o) const {
+  constexpr bool operator==(Vector<T> const &o) const {
     return _x == o._x && _y == o._y;
   }
 private:
@@ -30,12 +34,12 @@ private:
 };
 
 template <typename T, typename F>
-auto vmap(Vector<T> const &r, F const &f) -> Vector<decltype(f(r.x()))> {
+constexpr auto vmap(Vector<T> const &r, F const &f) -> Vector<decltype(f(r.x()))> {
   return Vector{f(r.x()), f(r.y())};
 }
 
 template <typename U, typename T>
-Vector<U> structure_cast(Vector<T> const &r) {
+constexpr Vector<U> structure_cast(Vector<T> const &r) {
   return vmap(r, [](T const &t) { return static_cast<U>(t); });
 }
 
@@ -45,7 +49,7 @@ Vector<U> rounding_cast(Vector<T> const &r) {
 }
 
 template <typename T>
-T dot(Vector<T> const &r, Vector<T> const &s) {
+constexpr T dot(Vector<T> const &r, Vector<T> const &s) {
   return r.x() * s.x() + r.y() * s.y();
 }
 
@@ -63,32 +67,32 @@ Vector<T> normalize(Vector<T> const &r) {
 }
 
 template <typename T>
-Vector<T> operator+(Vector<T> const &a, Vector<T> const &b) {
+constexpr Vector<T> operator+(Vector<T> const &a, Vector<T> const &b) {
   return Vector(a.x() + b.x(), a.y() + b.y());
 }
 
 template <typename T>
-Vector<T> operator*(Vector<T> const &a, Vector<T> const &b) {
+constexpr Vector<T> operator*(Vector<T> const &a, Vector<T> const &b) {
   return Vector(a.x() * b.x(), a.y() * b.y());
 }
 
 template <typename T>
-Vector<T> operator*(T const &a, Vector<T> const &b) {
+constexpr Vector<T> operator*(T const &a, Vector<T> const &b) {
   return Vector(a * b.x(), a * b.y());
 }
 
 template <typename T>
-Vector<T> operator-(Vector<T> const &a, Vector<T> const &b) {
+constexpr Vector<T> operator-(Vector<T> const &a, Vector<T> const &b) {
   return a + (-b);
 }
 
 template <typename T>
-Vector<T> operator/(Vector<T> const &a, T const &b) {
+constexpr Vector<T> operator/(Vector<T> const &a, T const &b) {
   return Vector(a.x() / b, a.y() / b);
 }
 
 template <typename T>
-Vector<T> operator*(Vector<T> const &a, T const &b) {
+constexpr Vector<T> operator*(Vector<T> const &a, T const &b) {
   return Vector(a.x() * b, a.y() * b);
 }
 
@@ -100,47 +104,47 @@ std::ostream &operator<<(std::ostream &os, Vector<T> const &v) {
 template <typename T>
 class Rectangle {
 public:
-  Rectangle(T const &_left, T const &_right, T const &_top, T const &_bottom)
+  constexpr Rectangle(T const &_left, T const &_right, T const &_top, T const &_bottom)
       : _left(_left), _right(_right), _top(_top), _bottom(_bottom) {}
 
-  static Rectangle<T>
+  static constexpr Rectangle<T>
   from_edges(Vector<T> const &left_top, Vector<T> const &right_bottom) {
     return Rectangle{
         left_top.x(), right_bottom.x(), left_top.y(), right_bottom.y()};
   }
 
-  static Rectangle<T>
+  static constexpr Rectangle<T>
   from_pos_and_size(Vector<T> const &pos, Vector<T> const &size) {
     return from_edges(pos, pos + size);
   }
 
-  static Rectangle<T>
+  static constexpr Rectangle<T>
   from_center_and_size(Vector<T> const &center, Vector<T> const &size) {
     return from_pos_and_size(center - size / static_cast<T>(2), size);
   }
 
-  static Rectangle<T>
+  static constexpr Rectangle<T>
   from_size_at_origin(Vector<T> const &size) {
     return from_edges(Vector<T>{0, 0}, size);
   }
 
-  T const &left() const { return _left; }
-  T const &right() const { return _right; }
-  T const &top() const { return _top; }
-  T const &bottom() const { return _bottom; }
+  constexpr T const &left() const { return _left; }
+  constexpr T const &right() const { return _right; }
+  constexpr T const &top() const { return _top; }
+  constexpr T const &bottom() const { return _bottom; }
 
-  T h() const { return _bottom - _top; }
-  T w() const { return _right - _left; }
+  constexpr T h() const { return _bottom - _top; }
+  constexpr T w() const { return _right - _left; }
 
-  Vector<T> position() const {
+  constexpr Vector<T> position() const {
     return Vector<T>{this->_left, this->_top};
   }
 
-  Vector<T> center() const {
+  constexpr Vector<T> center() const {
     return Vector<T>{this->_left + this->w() / 2, this->_top + this->h() / 2};
   }
 
-  Vector<T> size() const {
+  constexpr Vector<T> size() const {
     return Vector<T>{this->w(), this->h()};
   }
 private:
@@ -150,39 +154,70 @@ private:
   T _bottom;
 };
 
+// Touching edges count as intersecting.
 template <typename T>
-bool rect_intersect(Rectangle<T> const &outer, Rectangle<T> const &inner) {
-  auto const X1 = outer.left();
-  auto const X2 = inner.left();
-  auto const Y1 = outer.top();
-  auto const Y2 = inner.top();
-  auto const W1 = outer.w();
-  auto const W2 = inner.w();
-  auto const H1 = outer.h();
-  auto const H2 = inner.h();
-  return !(X1 + W1 < X2 || X2 + W2 < X1 || Y1 + H1 < Y2 || Y2 + H2 < Y1);
+constexpr bool rect_intersect(Rectangle<T> const &outer, Rectangle<T> const &inner) {
+  return !(outer.right() < inner.left() || inner.right() < outer.left() || outer.bottom() < inner.top() ||
+           inner.bottom() < outer.top());
+}
+
+// Smallest rectangle containing both
+template <typename T>
+constexpr Rectangle<T> rect_union(Rectangle<T> const &a, Rectangle<T> const &b) {
+  return Rectangle<T>{std::min(a.left(), b.left()), std::max(a.right(), b.right()),
+                      std::min(a.top(), b.top()), std::max(a.bottom(), b.bottom())};
+}
+
+// Sweeps `moving` along `motion` (slab test against the Minkowski sum) and
+// returns the fractions of the motion, clipped to [0, 1], at which it enters
+// and leaves `fixed`.
+template <typename T>
+std::optional<std::pair<T, T>> swept_intersect(
+    Rectangle<T> const &moving, Vector<T> const &motion, Rectangle<T> const &fixed) {
+  T enter{-std::numeric_limits<T>::infinity()};
+  T exit{std::numeric_limits<T>::infinity()};
+  auto const slab = [&enter, &exit](T const m, T const near_edge, T const far_edge, T const lo, T const hi) {
+    if (m == 0)
+      return !(near_edge < lo || far_edge > hi);
+    T const t1{(lo - near_edge) / m};
+    T const t2{(hi - far_edge) / m};
+    enter = std::max(enter, std::min(t1, t2));
+    exit = std::min(exit, std::max(t1, t2));
+    return true;
+  };
+  // A box overlaps the fixed one while its right edge is past fixed.left
+  // and its left edge before fixed.right.
+  if (!slab(motion.x(), moving.right(), moving.left(), fixed.left(), fixed.right()))
+    return std::nullopt;
+  if (!slab(motion.y(), moving.bottom(), moving.top(), fixed.top(), fixed.bottom()))
+    return std::nullopt;
+  if (enter > exit || exit < 0 || enter > 1)
+    return std::nullopt;
+  return std::make_pair(std::max(enter, T{0}), std::min(exit, T{1}));
 }
 
 template<typename T>
-Rectangle<T> embiggen(Rectangle<T> const &r, T const factor) {
+constexpr Rectangle<T> embiggen(Rectangle<T> const &r, T const factor) {
   auto const new_size{r.size() * factor};
   return Rectangle<T>::from_center_and_size(r.center(), new_size);
 }
 
 template <typename T, typename F>
-auto rect_map(Rectangle<T> const &r, F const &f)
+constexpr auto rect_map(Rectangle<T> const &r, F const &f)
     -> Rectangle<decltype(f(r.left()))> {
   return Rectangle(f(r.left()), f(r.right()), f(r.top()), f(r.bottom()));
 }
 
 template <typename U, typename T>
-Rectangle<U> structure_cast(Rectangle<T> const &r) {
+constexpr Rectangle<U> structure_cast(Rectangle<T> const &r) {
   return rect_map(r, [](T const &t) { return static_cast<U>(t); });
 }
 
 using IntVector = Vector<int>;
+using FloatVector = Vector<float>;
 using DoubleVector = Vector<double>;
 using IntRectangle = Rectangle<int>;
-using DoubleRectangle = Rectangle<int>;
+using FloatRectangle = Rectangle<float>;
+using DoubleRectangle = Rectangle<double>;
 
 } // namespace sg
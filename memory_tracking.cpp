@@ -0,0 +1,134 @@
+#include "memory_tracking.hpp"
+#include <atomic>
+#include <cstdlib>
+
+namespace {
+struct AtomicStats {
+  std::atomic<std::size_t> live_bytes;
+  std::atomic<std::size_t> peak_bytes;
+  std::atomic<std::size_t> allocations;
+  std::atomic<std::size_t> frame_allocations;
+};
+
+// Zero-initialized before any dynamic initialization, so allocations made
+// during static construction are counted too.
+std::array<AtomicStats, sg::memory_tag_count> stats;
+
+// Keeps the malloc'ed block size in front of what operator new returns.
+std::size_t const header_size{alignof(std::max_align_t)};
+
+AtomicStats &tag_stats(sg::MemoryTag const t) {
+  return stats[static_cast<std::size_t>(t)];
+}
+
+void add(AtomicStats &s, std::size_t const bytes) {
+  auto const live{s.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes};
+  auto peak{s.peak_bytes.load(std::memory_order_relaxed)};
+  while (live > peak && !s.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+  s.allocations.fetch_add(1, std::memory_order_relaxed);
+  s.frame_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void remove(AtomicStats &s, std::size_t const bytes) {
+  s.live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void *tracked_new(std::size_t const size) {
+  void *const block{std::malloc(size + header_size)};
+  if (block == nullptr)
+    return nullptr;
+  *static_cast<std::size_t *>(block) = size;
+  add(tag_stats(sg::MemoryTag::Total), size);
+  return static_cast<char *>(block) + header_size;
+}
+
+void tracked_delete(void *p) noexcept {
+  if (p == nullptr)
+    return;
+  void *const block{static_cast<char *>(p) - header_size};
+  remove(tag_stats(sg::MemoryTag::Total), *static_cast<std::size_t *>(block));
+  std::free(block);
+}
+
+void *throwing_new(std::size_t const size) {
+  void *const result{tracked_new(size)};
+  if (result == nullptr)
+    throw std::bad_alloc{};
+  return result;
+}
+}
+
+void *operator new(std::size_t const size) { return throwing_new(size); }
+
+void *operator new[](std::size_t const size) { return throwing_new(size); }
+
+void *operator new(std::size_t const size, std::nothrow_t const &) noexcept { return tracked_new(size); }
+
+void *operator new[](std::size_t const size, std::nothrow_t const &) noexcept { return tracked_new(size); }
+
+void operator delete(void *p) noexcept { tracked_delete(p); }
+
+void operator delete[](void *p) noexcept { tracked_delete(p); }
+
+void operator delete(void *p, std::size_t) noexcept { tracked_delete(p); }
+
+void operator delete[](void *p, std::size_t) noexcept { tracked_delete(p); }
+
+void operator delete(void *p, std::nothrow_t const &) noexcept { tracked_delete(p); }
+
+void operator delete[](void *p, std::nothrow_t const &) noexcept { tracked_delete(p); }
+
+void sg::record_allocation(MemoryTag const tag, std::size_t const bytes) {
+  add(tag_stats(tag), bytes);
+}
+
+void sg::record_deallocation(MemoryTag const tag, std::size_t const bytes) {
+  remove(tag_stats(tag), bytes);
+}
+
+sg::MemoryStats sg::memory_stats(MemoryTag const t) {
+  AtomicStats const &a{tag_stats(t)};
+  return MemoryStats{a.live_bytes.load(std::memory_order_relaxed),
+                     a.peak_bytes.load(std::memory_order_relaxed),
+                     a.allocations.load(std::memory_order_relaxed),
+                     a.frame_allocations.load(std::memory_order_relaxed)};
+}
+
+char const *sg::memory_tag_name(MemoryTag const t) {
+  switch (t) {
+    case MemoryTag::Textures:
+      return "textures";
+    case MemoryTag::Fonts:
+      return "fonts";
+    case MemoryTag::Console:
+      return "console";
+    case MemoryTag::GameState:
+      return "game state";
+    case MemoryTag::Render:
+      return "render";
+    case MemoryTag::Total:
+      return "total";
+  }
+  return "unknown";
+}
+
+sg::MemoryReport sg::end_memory_frame() {
+  MemoryReport result{};
+  for (std::size_t i{0}; i < result.size(); ++i) {
+    result[i] = memory_stats(static_cast<MemoryTag>(i));
+    result[i].frame_allocations = stats[i].frame_allocations.exchange(0, std::memory_order_relaxed);
+  }
+  return result;
+}
+
+std::vector<std::string> sg::format_memory_report(MemoryReport const &report) {
+  std::vector<std::string> result;
+  for (std::size_t i{0}; i < report.size(); ++i) {
+    MemoryStats const &s{report[i]};
+    result.push_back(std::string{memory_tag_name(static_cast<MemoryTag>(i))} +
+                     ": live " + std::to_string(s.live_bytes / 1024) + " KiB, peak " +
+                     std::to_string(s.peak_bytes / 1024) + " KiB, " + std::to_string(s.allocations) +
+                     " allocations, " + std::to_string(s.frame_allocations) + " in the last frame");
+  }
+  return result;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace sg {
+// Every heap allocation is counted under Total (by the replaced global
+// operator new); allocations made through TaggedAllocator are additionally
+// counted under their tag. All counters are relaxed atomics.
+enum class MemoryTag : unsigned {
+  Textures, Fonts, Console, GameState, Render, Total
+};
+
+std::size_t constexpr memory_tag_count{static_cast<std::size_t>(MemoryTag::Total) + 1};
+
+struct MemoryStats {
+  std::size_t live_bytes;
+  std::size_t peak_bytes;
+  std::size_t allocations;
+  // Allocations since the last end_memory_frame()
+  std::size_t frame_allocations;
+};
+
+void record_allocation(MemoryTag, std::size_t);
+
+void record_deallocation(MemoryTag, std::size_t);
+
+using MemoryReport = std::array<MemoryStats, memory_tag_count>;
+
+[[nodiscard]] MemoryStats memory_stats(MemoryTag);
+
+[[nodiscard]] char const *memory_tag_name(MemoryTag);
+
+// Returns the stats including the frame that ended and starts counting a
+// new one.
+MemoryReport end_memory_frame();
+
+[[nodiscard]] std::vector<std::string> format_memory_report(MemoryReport const &);
+
+template<typename T, MemoryTag Tag>
+class TaggedAllocator {
+public:
+  using value_type = T;
+  using is_always_equal = std::true_type;
+
+  template<typename U>
+  struct rebind {
+    using other = TaggedAllocator<U, Tag>;
+  };
+
+  TaggedAllocator() noexcept = default;
+
+  template<typename U>
+  explicit TaggedAllocator(TaggedAllocator<U, Tag> const &) noexcept {}
+
+  T *allocate(std::size_t const n) {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+      throw std::bad_array_new_length{};
+    record_allocation(Tag, n * sizeof(T));
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T *p, std::size_t const n) noexcept {
+    record_deallocation(Tag, n * sizeof(T));
+    ::operator delete(p);
+  }
+
+  template<typename U>
+  bool operator==(TaggedAllocator<U, Tag> const &) const noexcept { return true; }
+
+  template<typename U>
+  bool operator!=(TaggedAllocator<U, Tag> const &) const noexcept { return false; }
+};
+
+template<typename T, MemoryTag Tag>
+using TaggedVector = std::vector<T, TaggedAllocator<T, Tag>>;
+}
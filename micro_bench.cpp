@@ -0,0 +1,501 @@
+#include "Atlas.hpp"
+#include "Console.hpp"
+#include "GameState.hpp"
+#include "RenderObject.hpp"
+#include "SDL.hpp"
+#include "Starfield.hpp"
+#include "TextureCache.hpp"
+#include "batch_math.hpp"
+#include "constants.hpp"
+#include "lru.hpp"
+#include "math.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <thread>
+
+// Times small pieces of the engine in isolation and writes the results as
+// JSON, to have baselines to compare optimizations against. Each benchmark
+// is a fixture: set up once, reset (untimed) before every batch of runs.
+// A batch is sized to take at least `min_batch_time`; the median batch is
+// reported.
+//
+// Usage: spacegame_microbench [--filter <substring>] [--out <file.json>]
+// Run from the source directory, the atlas benchmarks read data/.
+
+namespace {
+std::chrono::milliseconds const min_batch_time{5};
+std::size_t const samples{15};
+
+// Keeps the compiler from dropping computations whose result is unused
+template<typename T>
+void keep(T const &value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+class Fixture {
+public:
+  virtual ~Fixture() = default;
+
+  // Work items done by one run(), for per-item timings
+  [[nodiscard]] virtual std::size_t items() const { return 1; }
+
+  // Runs per batch are capped so state doesn't drift too far from reset()
+  [[nodiscard]] virtual std::size_t max_runs() const { return std::numeric_limits<std::size_t>::max(); }
+
+  virtual void reset() {}
+
+  virtual void run() = 0;
+};
+
+struct Benchmark {
+  std::string name;
+  std::function<std::unique_ptr<Fixture>()> setup;
+};
+
+struct Measurement {
+  std::size_t runs_per_batch;
+  std::vector<double> ns_per_item;
+};
+
+Measurement measure(Fixture &f) {
+  // Grows the batch until it's long enough to time reliably
+  std::size_t runs{1};
+  while (true) {
+    f.reset();
+    auto const start{sg::Clock::now()};
+    for (std::size_t i{0}; i < runs; ++i)
+      f.run();
+    auto const elapsed{sg::Clock::now() - start};
+    if (elapsed >= min_batch_time || runs >= f.max_runs())
+      break;
+    runs = std::min(runs * 2, f.max_runs());
+  }
+  Measurement result{runs, {}};
+  for (std::size_t sample{0}; sample < samples; ++sample) {
+    f.reset();
+    auto const start{sg::Clock::now()};
+    for (std::size_t i{0}; i < runs; ++i)
+      f.run();
+    std::chrono::duration<double, std::nano> const elapsed{sg::Clock::now() - start};
+    result.ns_per_item.push_back(elapsed.count() / static_cast<double>(runs * f.items()));
+  }
+  std::sort(result.ns_per_item.begin(), result.ns_per_item.end());
+  return result;
+}
+
+std::vector<int> random_keys(std::size_t const count, int const range) {
+  sg::RandomEngine random_engine{1337};
+  std::uniform_int_distribution<int> key{0, range - 1};
+  std::vector<int> result(count);
+  for (int &k : result)
+    k = key(random_engine);
+  return result;
+}
+
+std::vector<sg::DoubleRectangle> random_rectangles(std::size_t const count) {
+  sg::RandomEngine random_engine{1337};
+  std::uniform_real_distribution<double> x{0, static_cast<double>(sg::game_size.x())};
+  std::uniform_real_distribution<double> y{0, static_cast<double>(sg::game_size.y())};
+  std::uniform_real_distribution<double> size{4, 128};
+  std::vector<sg::DoubleRectangle> result;
+  for (std::size_t i{0}; i < count; ++i)
+    result.push_back(sg::DoubleRectangle::from_pos_and_size(sg::DoubleVector{x(random_engine), y(random_engine)},
+                                                            sg::DoubleVector{size(random_engine), size(random_engine)}));
+  return result;
+}
+
+std::size_t const lru_capacity{1024};
+std::size_t const key_count{4096};
+
+// Half the keys miss, so about half the puts evict
+class LruPut : public Fixture {
+public:
+  LruPut() : keys_{random_keys(key_count, 2 * lru_capacity)}, lru_{lru_capacity} {}
+
+  std::size_t items() const override { return keys_.size(); }
+
+  void run() override {
+    for (int const k : keys_)
+      keep(lru_.put(k, int{k}));
+  }
+
+private:
+  std::vector<int> keys_;
+  sg::LRU<int, int> lru_;
+};
+
+class LruGet : public Fixture {
+public:
+  LruGet() : keys_{random_keys(key_count, lru_capacity)}, lru_{lru_capacity} {
+    for (std::size_t k{0}; k < lru_capacity; ++k)
+      lru_.put(static_cast<int>(k), static_cast<int>(k));
+  }
+
+  std::size_t items() const override { return keys_.size(); }
+
+  void run() override {
+    for (int const k : keys_)
+      keep(lru_.get(k));
+  }
+
+private:
+  std::vector<int> keys_;
+  sg::LRU<int, int> lru_;
+};
+
+// SDL's software renderer without a window, and the game's main atlas
+class AtlasFixture : public Fixture {
+public:
+  AtlasFixture()
+          : assets_{},
+            image_context_{assets_},
+            target_{SDL_CreateRGBSurfaceWithFormat(0, sg::game_size.x(), sg::game_size.y(), 32,
+                                                   SDL_PIXELFORMAT_ARGB8888)},
+            renderer_{software_renderer(target_)},
+            textures_{image_context_, renderer_},
+            atlases_{assets_, textures_} {
+    atlases_.get(sg::main_atlas_path);
+  }
+
+protected:
+  sg::AssetPack const assets_;
+  sg::SDLImageContext image_context_;
+  sg::SDLSurface target_;
+  sg::SDLRenderer renderer_;
+  sg::TextureCache textures_;
+  sg::AtlasCache atlases_;
+
+private:
+  static SDL_Renderer *software_renderer(sg::SDLSurface &target) {
+    if (target.surface() == nullptr)
+      throw std::runtime_error{"couldn't create target surface: " + std::string{SDL_GetError()}};
+    SDL_Renderer *const result{SDL_CreateSoftwareRenderer(target.surface())};
+    if (result == nullptr)
+      throw std::runtime_error{"couldn't create software renderer: " + std::string{SDL_GetError()}};
+    return result;
+  }
+};
+
+// Drawn outside the viewport, so SDL returns before blitting and what's
+// left is the tile lookup and call overhead.
+class AtlasRenderTile : public AtlasFixture {
+public:
+  AtlasRenderTile()
+          : atlas_{atlases_.get(sg::main_atlas_path)},
+            tiles_{sg::star_path, sg::ship_path, sg::laser_path, sg::enemy_texture(sg::EnemyType::AsteroidBig),
+                   sg::enemy_texture(sg::EnemyType::AsteroidMedium), sg::enemy_texture(sg::EnemyType::AsteroidSmall)} {}
+
+  std::size_t items() const override { return tiles_.size(); }
+
+  void run() override {
+    for (sg::TexturePath const &tile : tiles_)
+      atlas_.render_tile(renderer_, tile, offscreen);
+  }
+
+private:
+  static constexpr sg::IntRectangle offscreen{-100, -90, -100, -90};
+
+  sg::Atlas const &atlas_;
+  std::vector<sg::TexturePath> tiles_;
+};
+
+class AtlasCacheGet : public AtlasFixture {
+public:
+  AtlasCacheGet() {
+    atlases_.get(sg::explosion_animation);
+  }
+
+  std::size_t items() const override { return 2; }
+
+  void run() override {
+    keep(&atlases_.get(sg::main_atlas_path));
+    keep(&atlases_.get(sg::explosion_animation));
+  }
+};
+
+class RectIntersect : public Fixture {
+public:
+  RectIntersect() : rects_{random_rectangles(key_count)} {}
+
+  std::size_t items() const override { return rects_.size() - 1; }
+
+  void run() override {
+    std::size_t hits{0};
+    for (std::size_t i{1}; i < rects_.size(); ++i)
+      hits += sg::rect_intersect(rects_[i - 1], rects_[i]) ? 1 : 0;
+    keep(hits);
+  }
+
+private:
+  std::vector<sg::DoubleRectangle> rects_;
+};
+
+// One box against a packed batch, the collision broad phase. Setting up
+// checks the SIMD kernel against rect_intersect, with every remainder of
+// SIMD lanes and boxes that only touch.
+class BatchIntersecting : public Fixture {
+public:
+  BatchIntersecting() : probe_{100, 400, 200, 500}, boxes_{}, result_(key_count) {
+    for (sg::DoubleRectangle const &r : random_rectangles(key_count))
+      boxes_.push(sg::structure_cast<float>(r));
+    for (std::size_t n{0}; n <= 64; ++n)
+      check(n);
+    check(boxes_.size());
+  }
+
+  std::size_t items() const override { return boxes_.size(); }
+
+  void run() override {
+    keep(sg::intersecting(probe_, boxes_, result_.data()));
+  }
+
+private:
+  sg::FloatRectangle probe_;
+  sg::AabbBatch<> boxes_;
+  std::vector<std::uint32_t> result_;
+
+  void check(std::size_t const n) {
+    // Alternating touching and random boxes, so both land in every lane
+    sg::FloatRectangle const touching[]{
+            {probe_.right(), probe_.right() + 10, probe_.top(), probe_.bottom()},
+            {probe_.left() - 10, probe_.left(), probe_.top(), probe_.bottom()},
+            {probe_.left(), probe_.right(), probe_.bottom(), probe_.bottom() + 10},
+            {probe_.left(), probe_.right(), probe_.top() - 10, probe_.top()},
+            {probe_.right() + 1, probe_.right() + 10, probe_.top(), probe_.bottom()},
+            {probe_.left(), probe_.right(), probe_.bottom() + 1, probe_.bottom() + 10}};
+    sg::AabbBatch<> batch;
+    for (std::size_t i{0}; i < n; ++i)
+      batch.push(i % 2 == 0 ? touching[(i / 2) % std::size(touching)] : boxes_[i]);
+    std::vector<std::uint32_t> expected;
+    for (std::size_t i{0}; i < n; ++i)
+      if (sg::rect_intersect(probe_, batch[i]))
+        expected.push_back(static_cast<std::uint32_t>(i));
+    std::vector<std::uint32_t> actual(n);
+    actual.resize(sg::intersecting(probe_, batch, actual.data()));
+    if (actual != expected)
+      throw std::runtime_error{"batch intersection differs from rect_intersect for " + std::to_string(n) + " boxes"};
+  }
+};
+
+class Embiggen : public Fixture {
+public:
+  Embiggen() : rects_{random_rectangles(key_count)} {}
+
+  std::size_t items() const override { return rects_.size(); }
+
+  void run() override {
+    double sum{0};
+    for (sg::DoubleRectangle const &r : rects_)
+      sum += sg::embiggen(r, 2.0).left();
+    keep(sum);
+  }
+
+private:
+  std::vector<sg::DoubleRectangle> rects_;
+};
+
+class StarfieldUpdate : public Fixture {
+public:
+  StarfieldUpdate() : random_engine_{1337}, starfield_{random_engine_} {}
+
+  void run() override {
+    starfield_.update(sg::IntUpdateDiff{10});
+  }
+
+private:
+  sg::RandomEngine random_engine_;
+  sg::Starfield starfield_;
+};
+
+// `count` asteroids spread over the screen and about as many projectiles in
+// flight: half as many firing players, in a row across the screen, have
+// been shooting long enough for their volleys to fill the field above them
+// when the asteroids appear. One run is one 10 ms tick, which mostly tests
+// projectiles against asteroids. Every batch starts over from the same
+// snapshot.
+class GameStateUpdate : public Fixture {
+public:
+  explicit GameStateUpdate(std::size_t const count)
+          : random_engine_{1337},
+            console_{},
+            game_state_{random_engine_, console_, spawns(count), std::max(std::size_t{1}, count / 2)},
+            events_{},
+            start_{} {
+    for (sg::PlayerIndex i{0}; i < std::max(std::size_t{1}, count / 2); ++i)
+      game_state_.set_player_input(sg::PlayerInput{sg::IntVector{0, 0}, true}, i);
+    for (sg::IntUpdateDiff t{0}; t < warm_up; t += tick)
+      game_state_.update(tick, events_);
+    events_.discard();
+    start_ = game_state_.snapshot();
+  }
+
+  // Asteroids have mostly left the screen after ten seconds
+  std::size_t max_runs() const override { return 200; }
+
+  void reset() override {
+    game_state_.restore(start_);
+  }
+
+  void run() override {
+    game_state_.update(tick, events_);
+    events_.discard();
+  }
+
+private:
+  static constexpr sg::IntUpdateDiff tick{10};
+  // Projectiles take about that long from the players to the top
+  static constexpr sg::IntUpdateDiff warm_up{1200};
+
+  sg::RandomEngine random_engine_;
+  sg::Console console_;
+  sg::GameState game_state_;
+  sg::GameEventBus events_;
+  sg::Snapshot start_;
+
+  sg::SpawnList spawns(std::size_t const count) {
+    std::uniform_real_distribution<double> x{0, static_cast<double>(sg::game_size.x())};
+    std::uniform_real_distribution<double> y{0, static_cast<double>(sg::game_size.y())};
+    sg::SpawnList result;
+    for (std::size_t i{0}; i < count; ++i)
+      result.push_back(sg::EnemySpawn{static_cast<sg::EnemyType>(i % sg::enemy_type_count),
+                                      std::chrono::duration_cast<std::chrono::milliseconds>(warm_up),
+                                      sg::DoubleVector{x(random_engine_), y(random_engine_)},
+                                      1});
+    return result;
+  }
+};
+
+// Visits a mix like a frame's, with a visitor that only counts
+class RenderObjectVisit : public Fixture {
+public:
+  RenderObjectVisit() : objects_{} {
+    for (std::size_t i{0}; i < key_count; ++i) {
+      sg::IntRectangle const r{sg::IntRectangle::from_size_at_origin(sg::IntVector{10, 10})};
+      if (i % 8 == 0)
+        objects_.push_back(sg::Text{sg::console_font, "text", sg::IntVector{0, 0}, sg::console_font_color});
+      else if (i % 8 == 1)
+        objects_.push_back(sg::Solid{r, sg::console_background_color});
+      else
+        objects_.push_back(sg::Image{r, sg::main_atlas_path, sg::star_path});
+    }
+  }
+
+  std::size_t items() const override { return objects_.size(); }
+
+  void run() override {
+    Counter counter{};
+    for (sg::RenderObject const &o : objects_)
+      std::visit(counter, o);
+    keep(counter);
+  }
+
+private:
+  struct Counter {
+    std::size_t images;
+    std::size_t solids;
+    std::size_t text_bytes;
+
+    void operator()(sg::Image const &i) { images += static_cast<std::size_t>(i.rectangle.w()); }
+
+    void operator()(sg::Solid const &s) { solids += s.color.a; }
+
+    void operator()(sg::Text const &t) { text_bytes += t.text.size(); }
+  };
+
+  sg::RenderObjectList objects_;
+};
+
+template<typename F, typename... Args>
+Benchmark benchmark(std::string name, Args... args) {
+  return Benchmark{std::move(name), [args...]() { return std::unique_ptr<Fixture>{new F{args...}}; }};
+}
+
+std::string timestamp() {
+  std::time_t const now{std::time(nullptr)};
+  char s[32];
+  std::strftime(&s[0], sizeof(s), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+  return std::string{s};
+}
+}
+
+int main(int argc, char *argv[]) {
+  std::string filter;
+  std::optional<std::filesystem::path> out_path;
+  for (int i{1}; i < argc; ++i) {
+    std::string const arg{argv[i]};
+    if (arg == "--filter" && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (arg == "--out" && i + 1 < argc) {
+      out_path = argv[++i];
+    } else {
+      std::cerr << "usage: spacegame_microbench [--filter <substring>] [--out <file.json>]\n";
+      return 2;
+    }
+  }
+
+  std::vector<Benchmark> const benchmarks{
+          benchmark<LruPut>("lru/put"),
+          benchmark<LruGet>("lru/get"),
+          benchmark<AtlasRenderTile>("atlas/render_tile_lookup"),
+          benchmark<AtlasCacheGet>("atlas_cache/get"),
+          benchmark<RectIntersect>("math/rect_intersect"),
+          benchmark<BatchIntersecting>("math/batch_intersecting"),
+          benchmark<Embiggen>("math/embiggen"),
+          benchmark<StarfieldUpdate>("starfield/update"),
+          benchmark<GameStateUpdate>("game_state/update/100", std::size_t{100}),
+          benchmark<GameStateUpdate>("game_state/update/1000", std::size_t{1000}),
+          benchmark<GameStateUpdate>("game_state/update/10000", std::size_t{10000}),
+          benchmark<RenderObjectVisit>("render_object/visit"),
+  };
+
+  nlohmann::json results = nlohmann::json::array();
+  bool failed{false};
+  for (Benchmark const &b : benchmarks) {
+    if (b.name.find(filter) == std::string::npos)
+      continue;
+    try {
+      std::unique_ptr<Fixture> fixture{b.setup()};
+      Measurement const m{measure(*fixture)};
+      double const median{m.ns_per_item[m.ns_per_item.size() / 2]};
+      results.push_back({{"name", b.name},
+                         {"items_per_run", fixture->items()},
+                         {"runs_per_batch", m.runs_per_batch},
+                         {"batches", m.ns_per_item.size()},
+                         {"ns_per_item", median},
+                         {"min_ns_per_item", m.ns_per_item.front()},
+                         {"max_ns_per_item", m.ns_per_item.back()},
+                         {"items_per_second", median > 0 ? 1e9 / median : 0.0}});
+      std::cerr << b.name << ": " << median << " ns/item\n";
+    } catch (std::exception const &e) {
+      std::cerr << b.name << ": failed: " << e.what() << "\n";
+      failed = true;
+    }
+  }
+
+  nlohmann::json const report{{"context", {{"date", timestamp()},
+                                           {"hardware_threads", std::thread::hardware_concurrency()},
+                                           {"compiler", __VERSION__},
+#ifdef NDEBUG
+                                           {"assertions", false},
+#else
+                                           {"assertions", true},
+#endif
+                                           {"min_batch_ms", min_batch_time.count()}}},
+                              {"benchmarks", results}};
+  if (out_path.has_value()) {
+    std::ofstream out{out_path.value()};
+    out << report.dump(2) << "\n";
+  } else {
+    std::cout << report.dump(2) << "\n";
+  }
+  return failed ? 1 : 0;
+}
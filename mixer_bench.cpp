@@ -0,0 +1,58 @@
+#include "AudioMixer.hpp"
+#include "types.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Renders ten seconds of audio for increasing numbers of concurrent voices
+// into a buffer, without an audio device, and reports the time per output
+// frame and per voice frame.
+
+namespace {
+std::size_t const sample_rate{44100};
+std::size_t const seconds{10};
+// SDL_mixer's buffer size
+std::size_t const buffer_frames{1024};
+std::size_t const voice_counts[]{8, 32, 128, 256};
+
+sg::MixerSound tone(double const frequency, std::size_t const frames) {
+  std::vector<float> samples(frames * 2);
+  for (std::size_t i{0}; i < frames; ++i) {
+    auto const envelope{1.0 - static_cast<double>(i) / static_cast<double>(frames)};
+    auto const s{static_cast<float>(envelope * std::sin(6.283185 * frequency * static_cast<double>(i) / sample_rate))};
+    samples[i * 2] = s;
+    samples[i * 2 + 1] = s;
+  }
+  return sg::MixerSound{std::move(samples)};
+}
+}
+
+int main() {
+  std::vector<sg::MixerSound> sounds;
+  for (std::size_t i{0}; i < 16; ++i)
+    sounds.push_back(tone(220.0 + 40.0 * static_cast<double>(i), sample_rate / 4 + i * 1000));
+  std::vector<std::int16_t> output(buffer_frames * 2);
+  for (std::size_t const voices : voice_counts) {
+    sg::AudioMixer mixer;
+    float const gain{1.0f / static_cast<float>(voices)};
+    std::size_t next_sound{0};
+    std::size_t voice_frames{0};
+    sg::Clock::duration elapsed{0};
+    for (std::size_t rendered{0}; rendered < sample_rate * seconds; rendered += buffer_frames) {
+      // Keep the mixer busy like a scene retriggering effects
+      for (std::size_t v{mixer.active_voices()}; v < voices; ++v, ++next_sound)
+        mixer.play(sounds[next_sound % sounds.size()], gain, static_cast<float>(next_sound % 5) / 2.0f - 1.0f);
+      std::fill(output.begin(), output.end(), std::int16_t{0});
+      auto const start{sg::Clock::now()};
+      mixer.mix(output.data(), buffer_frames);
+      elapsed += sg::Clock::now() - start;
+      voice_frames += voices * buffer_frames;
+    }
+    std::chrono::duration<double, std::nano> const ns{elapsed};
+    auto const frames{static_cast<double>(sample_rate * seconds)};
+    std::cout << voices << " voices: " << ns.count() / frames << " ns/frame, "
+              << ns.count() / static_cast<double>(voice_frames) << " ns/voice frame, "
+              << static_cast<double>(seconds) / (ns.count() / 1e9) << "x realtime\n";
+  }
+}
@@ -0,0 +1,28 @@
+#include "AssetPack.hpp"
+#include <algorithm>
+#include <iostream>
+
+// Usage: spacegame_pack <output> <directory or file>...
+// Paths are stored as given, so run it from the directory the game is
+// started from (e.g. "spacegame_pack data.sgpack data").
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " <output> <directory or file>...\n";
+    return 1;
+  }
+  std::vector<std::filesystem::path> files;
+  for (int i{2}; i < argc; ++i) {
+    std::filesystem::path const p{argv[i]};
+    if (!std::filesystem::is_directory(p)) {
+      files.push_back(p);
+      continue;
+    }
+    for (std::filesystem::directory_entry const &e : std::filesystem::recursive_directory_iterator{p})
+      if (e.is_regular_file())
+        files.push_back(e.path());
+  }
+  std::sort(files.begin(), files.end());
+  sg::AssetPack::write(argv[1], files);
+  std::cout << "packed " << files.size() << " files into " << argv[1] << "\n";
+}
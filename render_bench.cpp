@@ -0,0 +1,179 @@
+#include "SDL.hpp"
+#include "Atlas.hpp"
+#include "Animation.hpp"
+#include "Console.hpp"
+#include "FontCache.hpp"
+#include "RenderObjectVisitor.hpp"
+#include "RenderQueue.hpp"
+#include "Starfield.hpp"
+#include "TextureCache.hpp"
+#include "constants.hpp"
+#include <functional>
+#include <iostream>
+
+// Renders scripted scenes offscreen with SDL's software renderer, through
+// the same RenderQueue/RenderObjectVisitor path as the game, and reports
+// frames per second and draw calls. The last frame of each scene is
+// compared with <golden dir>/<scene>.png. A missing golden image fails the
+// run unless --allow-missing is given.
+//
+// Usage: spacegame_renderbench [--record] [--allow-missing] [golden dir]
+//
+// The golden images in golden/ are recorded from a known good build with
+// `spacegame_renderbench --record` in the source directory. Re-record and
+// check them visually whenever a scene or a renderer change alters the
+// output on purpose.
+
+namespace {
+std::size_t const frames_per_scene{200};
+sg::IntUpdateDiff const tick{10};
+std::size_t const starfield_count{10};
+std::size_t const particle_count{2000};
+std::size_t const console_line_count{200};
+// Per channel difference still considered equal
+int const pixel_tolerance{2};
+
+using SceneFrame = std::function<void(sg::RenderQueue &)>;
+
+struct Scene {
+  std::string name;
+  SceneFrame frame;
+};
+
+sg::SDLSurface argb_copy(SDL_Surface *s) {
+  SDL_Surface *const converted{SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_ARGB8888, 0)};
+  if (converted == nullptr)
+    throw std::runtime_error{"couldn't convert surface: " + std::string{SDL_GetError()}};
+  return sg::SDLSurface{converted};
+}
+
+// Number of pixels differing by more than the tolerance
+std::size_t differing_pixels(sg::SDLSurface &a, sg::SDLSurface &b) {
+  SDL_Surface const *const sa{a.surface()};
+  SDL_Surface const *const sb{b.surface()};
+  if (sa->w != sb->w || sa->h != sb->h)
+    return static_cast<std::size_t>(std::max(sa->w * sa->h, sb->w * sb->h));
+  std::size_t result{0};
+  for (int y{0}; y < sa->h; ++y) {
+    auto const *const row_a{reinterpret_cast<Uint32 const *>(static_cast<Uint8 const *>(sa->pixels) + y * sa->pitch)};
+    auto const *const row_b{reinterpret_cast<Uint32 const *>(static_cast<Uint8 const *>(sb->pixels) + y * sb->pitch)};
+    for (int x{0}; x < sa->w; ++x)
+      for (unsigned shift{0}; shift < 32; shift += 8)
+        if (std::abs(static_cast<int>((row_a[x] >> shift) & 0xffu) - static_cast<int>((row_b[x] >> shift) & 0xffu)) >
+            pixel_tolerance) {
+          result++;
+          break;
+        }
+  }
+  return result;
+}
+}
+
+int main(int argc, char **argv) {
+  bool record{false};
+  bool allow_missing{false};
+  std::filesystem::path golden_dir{"golden"};
+  for (int i{1}; i < argc; ++i) {
+    std::string const arg{argv[i]};
+    if (arg == "--record")
+      record = true;
+    else if (arg == "--allow-missing")
+      allow_missing = true;
+    else
+      golden_dir = arg;
+  }
+
+  sg::AssetPack const assets;
+  sg::SDLImageContext image_context{assets};
+  sg::SDLTTFContext ttf_context{assets};
+  sg::SDLSurface target{
+          SDL_CreateRGBSurfaceWithFormat(0, sg::game_size.x(), sg::game_size.y(), 32, SDL_PIXELFORMAT_ARGB8888)};
+  if (target.surface() == nullptr)
+    throw std::runtime_error{"couldn't create target surface: " + std::string{SDL_GetError()}};
+  SDL_Renderer *const software_renderer{SDL_CreateSoftwareRenderer(target.surface())};
+  if (software_renderer == nullptr)
+    throw std::runtime_error{"couldn't create software renderer: " + std::string{SDL_GetError()}};
+  sg::SDLRenderer renderer{software_renderer};
+  sg::TextureCache textures{image_context, renderer};
+  sg::AtlasCache atlases{assets, textures};
+  sg::FontCache fonts{ttf_context, renderer};
+  sg::RenderQueue queue;
+  sg::RandomEngine random_engine{1337};
+  std::uniform_real_distribution<double> x{0, static_cast<double>(sg::game_size.x())};
+  std::uniform_real_distribution<double> y{0, static_cast<double>(sg::game_size.y())};
+
+  std::vector<sg::Starfield> starfields;
+  for (std::size_t i{0}; i < starfield_count; ++i)
+    starfields.emplace_back(random_engine);
+
+  std::vector<sg::Animation> particles;
+  std::uniform_int_distribution<int> age{0, static_cast<int>(sg::explosion_animation.animation->duration.count())};
+  for (std::size_t i{0}; i < particle_count; ++i) {
+    particles.emplace_back(sg::explosion_animation, sg::DoubleVector{x(random_engine), y(random_engine)});
+    particles.back().update(sg::AnimationDuration{age(random_engine)});
+  }
+
+  sg::Console console;
+  for (std::size_t i{0}; i < console_line_count; ++i)
+    console.add_line("console line " + std::to_string(i), false);
+  console.toggle();
+
+  std::vector<Scene> const scenes{
+          {"starfield", [&starfields](sg::RenderQueue &q) {
+            for (sg::Starfield &s : starfields) {
+              s.update(tick);
+              q.push(sg::RenderLayer::Background, s.draw());
+            }
+          }},
+          {"particles", [&particles, &random_engine, &x, &y](sg::RenderQueue &q) {
+            for (sg::Animation &a : particles) {
+              a.update(tick);
+              if (a.done())
+                a = sg::Animation{sg::explosion_animation, sg::DoubleVector{x(random_engine), y(random_engine)}};
+              q.push(sg::RenderLayer::Effects, a.render());
+            }
+          }},
+          {"console", [&console](sg::RenderQueue &q) {
+            q.push(sg::RenderLayer::Console, console.draw());
+          }},
+  };
+
+  bool all_match{true};
+  std::size_t missing{0};
+  for (Scene const &scene : scenes) {
+    auto const draw_calls_before{renderer.draw_calls()};
+    auto const start{sg::Clock::now()};
+    for (std::size_t frame{0}; frame < frames_per_scene; ++frame) {
+      renderer.clear();
+      scene.frame(queue);
+      queue.flush(sg::RenderObjectVisitor(renderer, atlases, fonts));
+      renderer.present();
+    }
+    std::chrono::duration<double> const elapsed{sg::Clock::now() - start};
+    std::cout << scene.name << ": " << static_cast<double>(frames_per_scene) / elapsed.count() << " fps, "
+              << static_cast<double>(renderer.draw_calls() - draw_calls_before) / frames_per_scene
+              << " draw calls/frame, ";
+
+    auto const golden_path{golden_dir / (scene.name + ".png")};
+    if (record) {
+      std::filesystem::create_directories(golden_dir);
+      image_context.save_png(target, golden_path);
+      std::cout << "recorded " << golden_path.string() << "\n";
+      continue;
+    }
+    if (!std::filesystem::exists(golden_path)) {
+      std::cout << "no golden image " << golden_path.string() << "\n";
+      missing++;
+      continue;
+    }
+    sg::SDLSurface golden_loaded{image_context.load_surface(golden_path)};
+    sg::SDLSurface golden{argb_copy(golden_loaded.surface())};
+    auto const differing{differing_pixels(target, golden)};
+    std::cout << (differing == 0 ? "matches golden image" : std::to_string(differing) + " pixels differ from golden image")
+              << "\n";
+    all_match = all_match && differing == 0;
+  }
+  if (missing > 0)
+    std::cout << missing << " scenes not checked, record golden images with --record\n";
+  return all_match && (missing == 0 || allow_missing) ? 0 : 1;
+}
@@ -1,28 +1,64 @@
 #pragma once
 
+#include <cstdint>
 #include <map>
+#include <list>
 #include <filesystem>
 #include "SDL.hpp"
+#include "AudioMixer.hpp"
 
 namespace sg {
+// Plays sound effects through an AudioMixer mixed over SDL_mixer's output,
+// so any number of them can overlap; SDL_mixer itself only plays music.
 class SoundCache {
 private:
-  using SoundMap = std::map<std::filesystem::path, sg::SDLMixerChunk>;
+  using SoundMap = std::map<std::filesystem::path, sg::MixerSound const *>;
 
 public:
   explicit SoundCache(sg::SDLMixerContext &_mixer_context)
-          : mixer_context_{_mixer_context} {}
+          : mixer_context_{_mixer_context}, storage_{}, _sounds{}, mixer_{}, played_{0} {
+    mixer_context_.post_mix(&mixer_);
+  }
+
+  SG_NONCOPYABLE(SoundCache);
+  SG_NONMOVEABLE(SoundCache);
 
+  ~SoundCache() {
+    mixer_context_.post_mix(nullptr);
+  }
+
+  void play_chunk(std::filesystem::path const &p, float const gain = 1.0f, float const pan = 0.0f) {
+    SoundMap::iterator it{_sounds.find(p)};
+    if (it == _sounds.end())
+      it = _sounds.insert(SoundMap::value_type{p, &store(mixer_context_.load_sound(p))}).first;
+    mixer_.play(*it->second, gain, pan);
+    played_++;
+  }
 
-  void play_chunk(std::filesystem::path const &p) {
+  // Returns false if the sound hasn't been played yet.
+  bool replace(std::filesystem::path const &p, sg::MixerSound sound) {
     SoundMap::iterator it{_sounds.find(p)};
-    if (it != _sounds.end())
-      mixer_context_.play_chunk(it->second);
-    mixer_context_.play_chunk(_sounds.insert(SoundMap::value_type{p, mixer_context_.load_chunk(p)}).first->second);
+    if (it == _sounds.end())
+      return false;
+    it->second = &store(std::move(sound));
+    return true;
   }
 
+  [[nodiscard]] sg::AudioMixer const &mixer() const { return mixer_; }
+
+  [[nodiscard]] std::uint64_t sounds_played() const { return played_; }
+
 private:
   sg::SDLMixerContext &mixer_context_;
+  // Never shrinks, as voices may still be playing a replaced sound
+  std::list<sg::MixerSound> storage_;
   SoundMap _sounds;
+  sg::AudioMixer mixer_;
+  std::uint64_t played_;
+
+  sg::MixerSound const &store(sg::MixerSound sound) {
+    storage_.push_back(std::move(sound));
+    return storage_.back();
+  }
 };
 }
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+namespace sg {
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+template<typename T, std::size_t Capacity>
+class SpscQueue {
+  static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+  SpscQueue() : slots_{}, head_{0}, tail_{0} {}
+
+  // Producer only; false when full.
+  bool push(T const &t) {
+    auto const tail{tail_.load(std::memory_order_relaxed)};
+    if (tail - head_.load(std::memory_order_acquire) == Capacity)
+      return false;
+    slots_[tail & (Capacity - 1)] = t;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only
+  std::optional<T> pop() {
+    auto const head{head_.load(std::memory_order_relaxed)};
+    if (head == tail_.load(std::memory_order_acquire))
+      return std::nullopt;
+    T result{slots_[head & (Capacity - 1)]};
+    head_.store(head + 1, std::memory_order_release);
+    return result;
+  }
+
+private:
+  std::array<T, Capacity> slots_;
+  alignas(64) std::atomic<std::size_t> head_;
+  alignas(64) std::atomic<std::size_t> tail_;
+};
+}